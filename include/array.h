@@ -0,0 +1,46 @@
+#pragma once
+#include "type.h"
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace squ {
+
+    // 类型化数组：元素不装箱、连续存储（每个元素8字节），算术与比较运算逐元素进行
+    // 成员：length() get(i) set(i, v) push(v) sum() min() max() slice(start, end) array()
+    // 元素也可以直接按下标读写：a[i]、a[i] = v、a[i] += v（不经过成员函数）
+    template <typename T> class TypedArray : public ObjectData {
+      public:
+        TypedArray() = default;
+        explicit TypedArray(std::vector<T> values) : data(std::move(values)) {}
+
+        std::string type_name() const override;
+
+        std::string string() const override;
+
+        ValueData member(const std::string &name) override;
+
+        bool element(long long index, ValueData &out) const override;
+
+        bool set_element(long long index, const ValueData &value) override;
+
+        std::vector<T> data; // 连续存储的元素
+    };
+
+    using Float64Array = TypedArray<double>;
+    using Int64Array = TypedArray<long long>;
+
+    // 包装为脚本值（移动存储，不拷贝元素）
+    template <typename T> ValueData MakeTypedArray(std::vector<T> values) {
+        return ValueData{ValueType::Object, false,
+                         std::shared_ptr<ObjectData>(std::make_shared<TypedArray<T>>(std::move(values)))};
+    }
+
+    // 从脚本值取出元素：接受类型化数组、数组或表（按索引顺序）
+    template <typename T> std::vector<T> ToTypedVector(const ValueData &source);
+
+    // 类型化数组的逐元素二元运算（+ - * / 与比较，另一侧可以是等长数组或标量）
+    // 两侧都不是类型化数组或运算符不适用时返回false，交给普通的运算规则
+    bool ApplyArrayBinary(const ValueData &lhs, const std::string &op, const ValueData &rhs, ValueData &result);
+
+} // namespace squ
\ No newline at end of file
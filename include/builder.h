@@ -0,0 +1,33 @@
+#pragma once
+#include "type.h"
+#include <string>
+#include <string_view>
+
+namespace squ {
+
+    // 字符串构建器：在同一块缓冲区上追加（容量按倍数增长），需要字符串时才取出
+    // 可以直接当作字符串传给接受字符串的函数
+    // 成员：append(...) length() reserve(n) clear() str()
+    class StringBuilder : public ObjectData {
+      public:
+        std::string type_name() const override {
+            return "builder";
+        }
+
+        // 字符串表示与字符串一致
+        std::string string() const override {
+            return "\"" + text + "\"";
+        }
+
+        ValueData member(const std::string &name) override;
+
+        bool bytes(std::string_view &out) const override {
+            out = text;
+            return true;
+        }
+
+      private:
+        std::string text;
+    };
+
+} // namespace squ
\ No newline at end of file
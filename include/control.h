@@ -0,0 +1,31 @@
+#pragma once
+#include "type.h"
+#include <exception>
+
+namespace squ {
+
+    // 控制流异常类
+    class BreakException : public std::exception {
+      public:
+        BreakException() : std::exception() {}
+    };
+
+    class ContinueException : public std::exception {
+      public:
+        ContinueException() : std::exception() {}
+    };
+
+    class ReturnException : public std::exception {
+      public:
+        ValueData value; // 返回值
+        explicit ReturnException(ValueData val) : value(std::move(val)) {}
+    };
+
+    // 生成器挂起异常：携带yield产出的值，由生成器对象捕获
+    class YieldException : public std::exception {
+      public:
+        ValueData value; // 产出值
+        explicit YieldException(ValueData val) : value(std::move(val)) {}
+    };
+
+} // namespace squ
\ No newline at end of file
@@ -0,0 +1,148 @@
+#pragma once
+#include "type.h"
+#include "vm.h"
+#include <cstdio>
+#include <functional>
+#include <memory>
+#include <queue>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace squ {
+
+    // 事件循环：定时器、非阻塞文件描述符、子进程管道与生成器协程
+    // 每个线程一个实例，回调都在调用run()的线程上、以run()传入的虚拟机执行，
+    // 因此单个解释器线程可以同时等待多个I/O和定时器。
+    // 文件描述符相关功能依赖epoll，仅在Linux上可用；其他平台只支持定时器、协程和文件任务。
+    class EventLoop {
+      public:
+        // 当前线程的事件循环
+        static EventLoop &current();
+
+        EventLoop();
+        ~EventLoop();
+        EventLoop(const EventLoop &) = delete;
+        EventLoop &operator=(const EventLoop &) = delete;
+
+        // 单调时钟（毫秒）
+        static long long now();
+
+        // 定时器：delay毫秒后调用callback()，interval大于0时周期触发，返回定时器编号
+        long long add_timer(long long delay, long long interval, ValueData callback);
+
+        // 协程：在循环中驱动生成器，yield整数n表示n毫秒后再恢复，其他值表示下一轮恢复
+        long long add_coroutine(ValueData generator);
+
+        // 取消定时器或协程
+        bool cancel(long long id);
+
+        // 监听可读：每读到一块数据调用callback(chunk)，读到结尾时调用callback("")并停止监听
+        void watch(int fd, ValueData callback);
+
+        // 非阻塞写：写不完的部分缓存起来，等待可写时继续
+        void write(int fd, std::string data);
+
+        // 关闭文件描述符（等待缓存的数据写完）
+        void close(int fd);
+
+        // 创建非阻塞管道，返回 {读端, 写端}
+        std::pair<int, int> pipe();
+
+        // 启动子进程（/bin/sh -c command），标准输出逐块交给onData，退出时调用onExit(status)
+        long long popen(const std::string &command, ValueData onData, ValueData onExit);
+
+        // 分块读取整个文件，读完后调用callback(content)；每轮循环只读一块，不会饿死其他事件
+        void read_file(const std::string &path, ValueData callback);
+
+        // 分块写入整个文件，写完后调用callback()
+        void write_file(const std::string &path, std::string content, ValueData callback);
+
+        // 运行直到没有待处理的事件或调用了stop()
+        void run(VM &vm);
+
+        // 请求停止循环
+        void stop();
+
+      private:
+        // 定时器队列项（按触发时间排序，取消的定时器在弹出时丢弃）
+        struct TimerEntry {
+            long long when;
+            long long id;
+            bool operator>(const TimerEntry &other) const {
+                return when != other.when ? when > other.when : id > other.id;
+            }
+        };
+
+        // 定时器或协程
+        struct Timer {
+            long long interval = 0;
+            ValueData callback;   // 普通定时器的回调
+            bool coroutine = false; // callback 是否为生成器对象
+        };
+
+        // 被监听的文件描述符
+        struct Watch {
+            ValueData onData;         // 可读回调（为Nil表示只用于写）
+            std::string output;       // 尚未写出的数据
+            bool closing = false;     // 写完后关闭
+            long long pid = -1;       // 子进程管道对应的进程号
+            ValueData onExit;         // 子进程退出回调
+            unsigned int events = 0;  // 当前注册的epoll事件
+        };
+
+        // 等待回收的子进程（管道已读到结尾）
+        struct Child {
+            long long pid;
+            ValueData onExit;
+        };
+
+        // 分块文件任务
+        struct FileJob {
+            std::string path;
+            bool writing = false;
+            std::string data;   // 读取结果或待写内容
+            size_t offset = 0;  // 已写出的字节数
+            std::shared_ptr<std::FILE> file;
+            ValueData callback;
+        };
+
+        // 触发到期的定时器与协程
+        void fire_timers(VM &vm);
+
+        // 推进一块文件任务
+        void step_file_jobs(VM &vm);
+
+        // 回收已退出的子进程
+        void reap_children(VM &vm);
+
+        // 等待并分发I/O事件
+        void poll(VM &vm, long long timeout);
+
+        // 处理可读事件，返回是否已到达结尾
+        bool handle_readable(int fd, VM &vm);
+
+        // 尝试写出缓存的数据
+        void flush(int fd);
+
+        // 根据监听状态更新epoll注册
+        void update_interest(int fd);
+
+        // 停止监听并关闭（不触发回调）
+        void release(int fd);
+
+        // 是否还有让循环继续的事件
+        bool alive() const;
+
+        std::priority_queue<TimerEntry, std::vector<TimerEntry>, std::greater<TimerEntry>> timerQueue;
+        std::unordered_map<long long, Timer> timers;
+        std::unordered_map<int, Watch> watches;
+        std::vector<FileJob> fileJobs;
+        std::vector<Child> children;
+        long long nextId = 1;
+        int pollFd = -1;
+        bool running = false;
+        bool stopping = false;
+    };
+
+} // namespace squ
\ No newline at end of file
@@ -0,0 +1,91 @@
+#pragma once
+#include "type.h"
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <string_view>
+
+namespace squ {
+
+    // 文件句柄对象：io.open(path, mode[, buffer]) 返回
+    // 读写都经过自己的块缓冲区（底层FILE不再缓冲），每次系统调用处理一整块；
+    // 逐行读取直接在块缓冲区里切出行，块在没有行视图引用时原地复用。
+    // 成员：read_line() lines() read() write(...) flush() close()
+    class FileHandle : public ObjectData {
+      public:
+        static constexpr size_t kDefaultBuffer = 64 * 1024;
+
+        // mode: "r" 读，"w" 截断写，"a" 追加写（可带 'b'）
+        FileHandle(const std::string &path, const std::string &mode, size_t bufferSize = kDefaultBuffer);
+        ~FileHandle() override;
+
+        std::string type_name() const override {
+            return "file";
+        }
+
+        std::string string() const override {
+            return "[file " + path + (file ? "" : " (closed)") + "]";
+        }
+
+        ValueData member(const std::string &name) override;
+
+        // 读取一行（去掉行尾的\n或\r\n），文件结束返回false；line在下一次读取前有效
+        bool read_line(std::string_view &line);
+
+        // 把刚读出的行包装成共享块缓冲区的视图
+        ValueData line_view(std::string_view line) const;
+
+        // 读取剩余的全部内容
+        std::string read_all();
+
+        // 写入（先进缓冲区，满一块再落盘）
+        void write(std::string_view data);
+
+        // 把缓冲区写入文件
+        void flush();
+
+        // 关闭文件（会先flush）
+        void close();
+
+      private:
+        // 检查文件仍然打开
+        void ensure_open() const;
+
+        // 读入下一块，返回是否读到了新数据
+        bool fill();
+
+        std::string path;
+        std::FILE *file = nullptr;
+        bool readable = false;
+        bool writable = false;
+        size_t bufferSize;
+
+        std::shared_ptr<std::string> block; // 读缓冲块（行视图共享它）
+        size_t pos = 0;                     // 块内未读部分的起点
+        size_t end = 0;                     // 块内有效数据的终点
+        bool eof = false;
+
+        std::string output; // 写缓冲区
+    };
+
+    // 行迭代器：next() 返回下一行的视图（结束后返回Nil），done() 判断是否结束
+    class FileLines : public ObjectData {
+      public:
+        explicit FileLines(std::shared_ptr<FileHandle> handle) : handle(std::move(handle)) {}
+
+        std::string type_name() const override {
+            return "lines";
+        }
+
+        ValueData member(const std::string &name) override;
+
+      private:
+        // 预读一行到pending
+        void prefetch();
+
+        std::shared_ptr<FileHandle> handle;
+        ValueData pending;
+        bool ready = false;
+    };
+
+} // namespace squ
\ No newline at end of file
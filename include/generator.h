@@ -0,0 +1,47 @@
+#pragma once
+#include "node.h"
+#include "type.h"
+#include "vm.h"
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace squ {
+
+    // 生成器对象：调用含yield的函数时返回，每次next()执行到下一个yield
+    // 挂起时帧内的局部变量搬出保存在对象里，原生栈完全展开，
+    // 因此一个挂起的生成器只占用其帧大小和恢复路径的空间。
+    // 生成器不是线程安全的，不要在多个任务间共享同一个生成器。
+    class GeneratorData : public ObjectData {
+      public:
+        GeneratorData(std::shared_ptr<ExprNode> body, std::vector<ValueData> locals)
+            : body(std::move(body)), locals(std::move(locals)) {}
+
+        std::string type_name() const override {
+            return "generator";
+        }
+
+        // 成员：next([value]) 取下一个值（耗尽后返回Nil），done() 判断是否耗尽
+        ValueData member(const std::string &name) override;
+
+        // 取下一个产出值；sent作为上一次yield表达式的值
+        ValueData next(VM &vm, ValueData sent);
+
+        // 是否已经耗尽（必要时先执行到下一个yield并缓存其值）
+        bool done(VM &vm);
+
+      private:
+        // 恢复执行直到下一个yield或函数结束
+        void advance(VM &vm, ValueData sent);
+
+        std::shared_ptr<ExprNode> body;
+        std::vector<ValueData> locals; // 挂起时保存的帧
+        Coroutine state;               // 恢复路径
+        ValueData value;               // 已产出但尚未被取走的值
+        bool started = false;
+        bool ready = false; // value 是否有效
+        bool finished = false;
+        bool running = false;
+    };
+
+} // namespace squ
\ No newline at end of file
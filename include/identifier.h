@@ -1,18 +1,94 @@
 #pragma once
 
+#include "array.h"
 #include "type.h"
 #include <algorithm> // 添加 algorithm 头文件
 #include <cmath>
+#include <cstdint>
 #include <functional>
 #include <map>
+#include <memory>
 #include <stdexcept>
 #include <string>
+#include <string_view>
 #include <tuple>
 #include <type_traits>
 #include <utility>
 #include <variant>
 #include <vector>
 
+namespace squ {
+
+    // 原生函数：FunctionWrapper 按C++签名在编译期生成的调用描述。
+    // thunk 是单态的调用桩，从实参指针数组取参数并调用被包装的对象，
+    // 不再经过 std::function 的间接调用；arity 与 params 供解析期和调用前检查参数。
+    // 实参以指针传入，调用方可以直接借用变量、表成员或数组元素本身而不拷贝：
+    // refParams的第i位表示第i个参数是可写引用（ValueData&、TableData&等），实参是变量时指向变量本身，
+    // 因此会直接修改调用方的变量；ownedParams的第i位表示转换时可能改写实参（如const std::string&），
+    // 需要交给调用桩一份副本；其余参数只读，可以指向借用的值
+    struct NativeFunction {
+        using Thunk = ValueData (*)(void *target, ValueData *const *args, VM &vm);
+
+        // 连续实参数组转成指针数组时放在栈上的个数上限
+        static constexpr size_t kInlineArgs = 8;
+
+        std::shared_ptr<void> target;      // 被包装的可调用对象
+        Thunk thunk = nullptr;             // 调用桩
+        size_t arity = 0;                  // 参数个数
+        const ValueType *params = nullptr; // 各参数期望的类型（Nil表示任意类型）
+        uint64_t refParams = 0;            // 可写引用参数
+        uint64_t ownedParams = 0;          // 转换时可能改写实参的参数
+
+        // 检查参数个数
+        void check_arity(size_t count) const {
+            if (count != arity) {
+                throw std::runtime_error("[squaker.wrapper] Incorrect number of arguments. Expected: " +
+                                         std::to_string(arity) + ", got: " + std::to_string(count));
+            }
+        }
+
+        // 直接调用：args[i] 指向第i个实参
+        ValueData call(ValueData *const *args, VM &vm) const {
+            return thunk(target.get(), args, vm);
+        }
+
+        // 直接调用：args 指向 arity 个连续的实参
+        ValueData call(ValueData *args, VM &vm) const {
+            ValueData *inlineArgs[kInlineArgs];
+            std::vector<ValueData *> heapArgs;
+            ValueData **pointers = inlineArgs;
+            if (arity > kInlineArgs) {
+                heapArgs.resize(arity);
+                pointers = heapArgs.data();
+            }
+            for (size_t i = 0; i < arity; i++)
+                pointers[i] = args + i;
+            return thunk(target.get(), pointers, vm);
+        }
+
+        // 兼容 std::function 的调用方式
+        ValueData operator()(std::vector<ValueData> &args, VM &vm) const {
+            check_arity(args.size());
+            return call(args.data(), vm);
+        }
+    };
+
+    // 取出函数值中的原生函数描述（脚本函数或 Native 注册的函数返回空）
+    inline const NativeFunction *AsNative(const ValueData &function) {
+        if (function.type != ValueType::Function)
+            return nullptr;
+        return std::get<std::function<ValueData(std::vector<ValueData> &, VM &)>>(function.value)
+            .target<NativeFunction>();
+    }
+
+    // 参数类型是否可能被接受（Nil表示任意类型；实数参数也接受整数）
+    inline bool AcceptsParam(ValueType expected, ValueType actual) {
+        return expected == ValueType::Nil || expected == actual ||
+               (expected == ValueType::Real && actual == ValueType::Integer);
+    }
+
+} // namespace squ
+
 namespace squ::internal {
 
     // 类型转换工具
@@ -82,48 +158,227 @@ namespace squ::internal {
     template <> struct TypeConverter<std::string> {
         static constexpr ValueType type = ValueType::String;
         static std::string convert(const ValueData &v) {
+            std::string_view bytes;
+            if (v.type == ValueType::Object && std::get<std::shared_ptr<ObjectData>>(v.value)->bytes(bytes))
+                return std::string(bytes); // 字节视图需要拥有所有权时才拷贝
             if (v.type != ValueType::String)
                 throw std::runtime_error("[squaker.wrapper] Expected string type");
-            return std::get<std::string>(v.value);
+            return std::string(std::get<StringData>(v.value).view());
         }
         static ValueData convert_to_value(const std::string &value) {
             return ValueData{ValueType::String, false, value};
         }
     };
 
+    // 字符串只读视图：接受字符串或字节视图对象，不拷贝内容（只在本次调用期间有效）
+    template <> struct TypeConverter<std::string_view> {
+        static constexpr ValueType type = ValueType::String;
+        static std::string_view convert(const ValueData &v) {
+            if (v.type == ValueType::String)
+                return std::get<StringData>(v.value).view();
+            std::string_view bytes;
+            if (v.type == ValueType::Object && std::get<std::shared_ptr<ObjectData>>(v.value)->bytes(bytes))
+                return bytes;
+            throw std::runtime_error("[squaker.wrapper] Expected string type");
+        }
+        static ValueData convert_to_value(std::string_view value) {
+            return ValueData{ValueType::String, false, std::string(value)};
+        }
+    };
+
+    // ValueData 原样传递（回调等需要保留脚本值的参数）
+    template <> struct TypeConverter<ValueData> {
+        static constexpr ValueType type = ValueType::Nil;
+        static ValueData convert(const ValueData &v) {
+            return v;
+        }
+        static ValueData convert_to_value(ValueData value) {
+            return value;
+        }
+    };
+
+    // 数值列与类型化数组互转：连续存储，整块拷贝或移动
+    template <> struct TypeConverter<std::vector<double>> {
+        static constexpr ValueType type = ValueType::Object;
+        static std::vector<double> convert(const ValueData &v) {
+            return ToTypedVector<double>(v);
+        }
+        static ValueData convert_to_value(std::vector<double> values) {
+            return MakeTypedArray(std::move(values));
+        }
+    };
+    template <> struct TypeConverter<std::vector<long long>> {
+        static constexpr ValueType type = ValueType::Object;
+        static std::vector<long long> convert(const ValueData &v) {
+            return ToTypedVector<long long>(v);
+        }
+        static ValueData convert_to_value(std::vector<long long> values) {
+            return MakeTypedArray(std::move(values));
+        }
+    };
+
+    // 引用参数：直接引用实参本身，不拷贝
+    // 调用方传入变量时实参就是变量本身（只读引用还可以是表成员、数组元素，见 NativeFunction）
+    template <> struct TypeConverter<const ValueData &> {
+        static constexpr ValueType type = ValueType::Nil;
+        static const ValueData &convert(const ValueData &v) {
+            return v;
+        }
+    };
+    template <> struct TypeConverter<ValueData &> {
+        static constexpr ValueType type = ValueType::Nil;
+        static ValueData &convert(ValueData &v) {
+            return v;
+        }
+    };
+    template <> struct TypeConverter<const TableData &> {
+        static constexpr ValueType type = ValueType::Table;
+        static const TableData &convert(const ValueData &v) {
+            if (v.type != ValueType::Table)
+                throw std::runtime_error("[squaker.wrapper] Expected table type");
+            return std::get<TableData>(v.value);
+        }
+    };
+    template <> struct TypeConverter<TableData &> {
+        static constexpr ValueType type = ValueType::Table;
+        static TableData &convert(ValueData &v) {
+            if (v.type != ValueType::Table)
+                throw std::runtime_error("[squaker.wrapper] Expected table type");
+            if (v.is_const)
+                throw std::runtime_error("[squaker.wrapper] Cannot modify a const table");
+            return std::get<TableData>(v.value);
+        }
+    };
+    template <> struct TypeConverter<const std::vector<ValueData> &> {
+        static constexpr ValueType type = ValueType::Array;
+        static const std::vector<ValueData> &convert(const ValueData &v) {
+            if (v.type != ValueType::Array)
+                throw std::runtime_error("[squaker.wrapper] Expected array type");
+            return std::get<std::vector<ValueData>>(v.value);
+        }
+    };
+    template <> struct TypeConverter<std::vector<ValueData> &> {
+        static constexpr ValueType type = ValueType::Array;
+        static std::vector<ValueData> &convert(ValueData &v) {
+            if (v.type != ValueType::Array)
+                throw std::runtime_error("[squaker.wrapper] Expected array type");
+            if (v.is_const)
+                throw std::runtime_error("[squaker.wrapper] Cannot modify a const array");
+            return std::get<std::vector<ValueData>>(v.value);
+        }
+    };
+
+    // const std::string&：字符串直接引用；字节视图与切片就地换成字符串（实参表是本次调用的副本）
+    template <> struct TypeConverter<const std::string &> {
+        static constexpr ValueType type = ValueType::String;
+        static const std::string &convert(ValueData &v) {
+            if (v.type != ValueType::String)
+                v = ValueData{ValueType::String, false, TypeConverter<std::string>::convert(v)};
+            return std::get<StringData>(v.value).flat();
+        }
+    };
+
+    // 连续数值的视图参数（C++17没有std::span）：引用类型化数组的存储，不拷贝；非const版本可以原地修改
+    template <typename T> class Span {
+      public:
+        Span(T *data, size_t size) : ptr(data), count(size) {}
+        T *data() const {
+            return ptr;
+        }
+        size_t size() const {
+            return count;
+        }
+        bool empty() const {
+            return count == 0;
+        }
+        T &operator[](size_t i) const {
+            return ptr[i];
+        }
+        T *begin() const {
+            return ptr;
+        }
+        T *end() const {
+            return ptr + count;
+        }
+
+      private:
+        T *ptr;
+        size_t count;
+    };
+
+    template <typename T>
+    struct TypeConverter<Span<T>, std::enable_if_t<std::is_same_v<std::remove_const_t<T>, double> ||
+                                                   std::is_same_v<std::remove_const_t<T>, long long>>> {
+        using Element = std::remove_const_t<T>;
+        static constexpr ValueType type = ValueType::Object;
+        static Span<T> convert(const ValueData &v) {
+            if (v.type == ValueType::Object) {
+                if (auto *array = dynamic_cast<TypedArray<Element> *>(std::get<std::shared_ptr<ObjectData>>(v.value).get()))
+                    return Span<T>(array->data.data(), array->data.size());
+            }
+            throw std::runtime_error(std::is_same_v<Element, double> ? "[squaker.wrapper] Expected float64array"
+                                                                     : "[squaker.wrapper] Expected int64array");
+        }
+    };
+
+    // 可写引用参数：调用方传入变量时直接引用变量本身
+    template <typename T> struct is_writable_param : std::false_type {};
+    template <typename T>
+    struct is_writable_param<T &>
+        : std::bool_constant<!std::is_const_v<T> && (std::is_same_v<T, ValueData> || std::is_same_v<T, TableData> ||
+                                                     std::is_same_v<T, std::vector<ValueData>>)> {};
+
+    // 转换时可能改写实参的参数（字节视图就地换成字符串）
+    template <typename T> struct is_owned_param : std::is_same<T, const std::string &> {};
+
+    // 按参数类型生成位掩码
+    template <template <typename> class Pred, typename Traits, size_t... Is>
+    constexpr uint64_t param_mask(std::index_sequence<Is...>) {
+        return (uint64_t{0} | ... |
+                (Pred<typename Traits::template arg_type<Is>>::value ? (uint64_t{1} << Is) : 0));
+    }
+
     // std::vector<T> 到 ValueData的转换
     template <typename T> struct TypeConverter<std::vector<T>> {
         static constexpr ValueType type = ValueType::Table;
 
         static std::vector<T> convert(const ValueData &v) {
+            if (v.type == ValueType::Array) {
+                // 紧凑数组直接逐元素转换
+                const auto &elements = std::get<std::vector<ValueData>>(v.value);
+                std::vector<T> result;
+                result.reserve(elements.size());
+                for (const auto &element : elements)
+                    result.push_back(TypeConverter<T>::convert(element));
+                return result;
+            }
             if (v.type != ValueType::Table) {
-                throw std::runtime_error("[squaker.wrapper] Expected table type");
+                throw std::runtime_error("[squaker.wrapper] Expected table or array type");
             }
 
             const TableData &table = std::get<TableData>(v.value);
             std::vector<T> result;
-            result.reserve(table.array_map.size());
+            result.reserve(table.array_size());
 
             // 按索引顺序提取值
-            for (const auto &[key, value] : table.array_map) {
+            table.for_each_index([&result](const ValueData &key, const ValueData &value) {
                 if (key.type != ValueType::Integer) {
                     throw std::runtime_error("[squaker.wrapper] Expected integer index in table array");
                 }
                 result.push_back(TypeConverter<T>::convert(value));
-            }
+            });
 
             return result;
         }
 
-        static ValueData convert_to_value(const std::vector<T> &vec) {
-            TableData table;
-            long long index = 0;
-
-            for (const auto &item : vec) {
-                table.index(ValueData{ValueType::Integer, false, index++}) = TypeConverter<T>::convert_to_value(item);
+        // 返回紧凑数组，元素逐个移入
+        static ValueData convert_to_value(std::vector<T> vec) {
+            std::vector<ValueData> elements;
+            elements.reserve(vec.size());
+            for (auto &item : vec) {
+                elements.push_back(TypeConverter<T>::convert_to_value(std::move(item)));
             }
-
-            return ValueData{ValueType::Table, false, table};
+            return ValueData{ValueType::Array, false, std::move(elements)};
         }
     };
     
@@ -139,17 +394,16 @@ namespace squ::internal {
             const TableData &table = std::get<TableData>(v.value);
             std::map<K, V> result;
 
-            // 只转换 array_map 部分
-            for (const auto &[key, value] : table.array_map) {
+            // 只转换数组部分
+            table.for_each_index([&result](const ValueData &key, const ValueData &value) {
                 try {
                     K converted_key = TypeConverter<K>::convert(key);
                     V converted_value = TypeConverter<V>::convert(value);
                     result[converted_key] = converted_value;
                 } catch (const std::exception &e) {
                     // 跳过无法转换的条目
-                    continue;
                 }
-            }
+            });
 
             return result;
         }
@@ -208,31 +462,49 @@ namespace squ::internal {
     template <typename F> struct function_traits<F &> : function_traits<F> {};
     template <typename F> struct function_traits<F &&> : function_traits<F> {};
 
+    // 参数类型表（每个签名一份静态数据）
+    template <typename Traits, size_t... Is> struct ParamTypes {
+        static constexpr ValueType value[sizeof...(Is) + 1] = {
+            TypeConverter<typename Traits::template arg_type<Is>>::type..., ValueType::Nil};
+    };
+
     // 统一的函数包装器
     template <typename Func> struct FunctionWrapper {
+        using Fn = std::decay_t<Func>;
+        using traits = function_traits<Fn>;
+        using Indices = std::make_index_sequence<traits::arity>;
+
         static ValueData wrap(Func &&func) {
-            using traits = function_traits<std::decay_t<Func>>;
-            return ValueData{
-                ValueType::Function, false,
-                [func = std::forward<Func>(func)](std::vector<ValueData> &args, VM &) mutable -> ValueData {
-                    if (args.size() != traits::arity) {
-                        throw std::runtime_error("[squaker.wrapper] Incorrect number of arguments. Expected: " +
-                                                 std::to_string(traits::arity));
-                    }
-                    return call_impl(func, args, std::make_index_sequence<traits::arity>{});
-                }};
+            NativeFunction native;
+            native.target = std::make_shared<Fn>(std::forward<Func>(func));
+            native.thunk = &thunk;
+            native.arity = traits::arity;
+            native.params = param_types(Indices{});
+            // 记录各参数的传递方式，调用方据此决定借用还是拷贝实参
+            native.refParams = param_mask<is_writable_param, traits>(Indices{});
+            native.ownedParams = param_mask<is_owned_param, traits>(Indices{});
+            return ValueData{ValueType::Function, false,
+                             std::function<ValueData(std::vector<ValueData> &, VM &)>(std::move(native))};
         }
 
       private:
-        template <typename F, size_t... Is>
-        static ValueData call_impl(F &func, std::vector<ValueData> &args, std::index_sequence<Is...>) {
-            using traits = function_traits<std::decay_t<F>>;
+        // 调用桩：参数个数由调用方检查
+        static ValueData thunk(void *target, ValueData *const *args, VM &) {
+            return call_impl(*static_cast<Fn *>(target), args, Indices{});
+        }
+
+        template <size_t... Is> static const ValueType *param_types(std::index_sequence<Is...>) {
+            return ParamTypes<traits, Is...>::value;
+        }
+
+        template <size_t... Is>
+        static ValueData call_impl(Fn &func, ValueData *const *args, std::index_sequence<Is...>) {
             if constexpr (std::is_same_v<typename traits::result_type, void>) {
-                func(TypeConverter<typename traits::template arg_type<Is>>::convert(args[Is])...);
+                func(TypeConverter<typename traits::template arg_type<Is>>::convert(*args[Is])...);
                 return ValueData{ValueType::Nil, false};
             } else {
-                auto result = func(TypeConverter<typename traits::template arg_type<Is>>::convert(args[Is])...);
-                return convert_to_value(result);
+                auto result = func(TypeConverter<typename traits::template arg_type<Is>>::convert(*args[Is])...);
+                return convert_to_value(std::move(result));
             }
         }
     };
@@ -295,7 +567,7 @@ namespace squ::internal {
         using Raw = std::string;
         static constexpr ValueType type = ValueType::String;
         static std::string convert(const ValueData &v) {
-            return std::get<std::string>(v.value);
+            return TypeConverter<std::string>::convert(v);
         }
         static ValueData convert_to_value(const Raw &v) {
             return ValueData{ValueType::String, false, v};
@@ -329,6 +601,12 @@ namespace squ {
         return {std::string(name), func};
     }
 
+    // 工厂函数：按原生签名注册，直接接收参数数组和虚拟机（需要回调脚本函数时使用）
+    inline IdentifierData Native(std::string_view name,
+                                 std::function<ValueData(std::vector<ValueData> &, VM &)> f) {
+        return {std::string(name), ValueData{ValueType::Function, true, std::move(f)}};
+    }
+
     template <typename T> inline IdentifierData Variable(std::string_view name, T &&v) {
         return {std::string(name), to_value(std::forward<T>(v))};
     }
@@ -341,7 +619,7 @@ namespace squ {
 
     template <typename... Items> inline IdentifierData Namespace(std::string_view name, Items &&...items) {
         TableData tbl;
-        (void(tbl.dot_map.emplace(items.name, items.value)), ...);
+        (void(tbl.emplace_dot(items.name, items.value)), ...);
         return {std::string(name), ValueData{ValueType::Table, false, tbl}};
     }
 
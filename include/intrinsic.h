@@ -0,0 +1,46 @@
+#pragma once
+#include "identifier.h"
+#include "node.h"
+#include "vm.h"
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace squ {
+
+    // 内建函数（@name(...)）的实现：参数以语法节点传入，由实现自行决定如何求值（如@print逐个格式化输出）
+    using Intrinsic = ValueData (*)(const std::vector<std::unique_ptr<ExprNode>> &args, VM &vm);
+
+    // 注册表中的一项，地址在进程内保持不变，解析器直接把它存进语法节点
+    struct IntrinsicInfo {
+        static constexpr size_t npos = static_cast<size_t>(-1);
+
+        std::string name;
+        Intrinsic call = nullptr; // 语法级内建函数
+        ValueData function;       // 按C++签名包装的内建函数（call为空时使用）
+        size_t minArgs = 0;       // 参数个数下限
+        size_t maxArgs = npos;    // 参数个数上限（npos表示不限）
+
+        // 包装函数的调用描述（语法级内建函数返回空）
+        const NativeFunction *native() const {
+            return AsNative(function);
+        }
+    };
+
+    // 注册语法级内建函数，同名已存在时抛出异常
+    void RegisterIntrinsic(std::string name, Intrinsic call, size_t minArgs = 0,
+                           size_t maxArgs = IntrinsicInfo::npos);
+
+    // 注册按C++签名包装的内建函数（参数个数与类型在解析期检查）
+    void RegisterIntrinsic(std::string name, ValueData function);
+
+    template <typename F> inline void RegisterIntrinsic(std::string name, F &&f) {
+        RegisterIntrinsic(std::move(name), make_function(std::forward<F>(f)));
+    }
+
+    // 按名字查找内建函数，找不到返回空
+    const IntrinsicInfo *FindIntrinsic(const std::string &name);
+
+} // namespace squ
\ No newline at end of file
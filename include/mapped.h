@@ -0,0 +1,89 @@
+#pragma once
+#include "type.h"
+#include <memory>
+#include <string>
+#include <string_view>
+
+namespace squ {
+
+    // 只读内存映射文件：内容直接来自页缓存，不经过用户态拷贝
+    class MappedFile {
+      public:
+        explicit MappedFile(const std::string &path);
+        ~MappedFile();
+        MappedFile(const MappedFile &) = delete;
+        MappedFile &operator=(const MappedFile &) = delete;
+
+        const char *data() const {
+            return ptr;
+        }
+        size_t size() const {
+            return length;
+        }
+
+      private:
+        const char *ptr = nullptr; // 空文件不映射，保持为空
+        size_t length = 0;
+#ifdef _WIN32
+        void *fileHandle = nullptr;
+        void *mappingHandle = nullptr;
+#endif
+    };
+
+    // 字节视图对象：引用所有者（如映射文件）中的一段内容，切片共享同一个所有者
+    // 成员：length() at(i) slice(start, end) find(sub[, from]) lines() str()
+    // 相等比较、表键和switch中与内容相同的字符串等价（作为表键存入时转为字符串）
+    class ByteView : public ObjectData {
+      public:
+        ByteView(std::shared_ptr<const void> owner, std::string_view content)
+            : owner(std::move(owner)), content(content) {}
+
+        std::string type_name() const override {
+            return "view";
+        }
+
+        // 字符串表示与字符串一致
+        std::string string() const override {
+            return "\"" + std::string(content) + "\"";
+        }
+
+        ValueData member(const std::string &name) override;
+
+        bool bytes(std::string_view &out) const override {
+            out = content;
+            return true;
+        }
+
+        // 生成同一所有者上的子视图
+        ValueData slice(size_t start, size_t end) const;
+
+      private:
+        std::shared_ptr<const void> owner; // 保证视图存活期间内容有效
+        std::string_view content;
+    };
+
+    // 字符串或字节视图的子串 [start, end)：视图返回共享所有者的子视图，字符串返回共享内容的切片
+    // （很短的子串直接复制，见 StringData::slice），都不拷贝源内容
+    ValueData SliceBytes(const ValueData &source, size_t start, size_t end);
+
+    // 把字符串转为字节视图（与字符串共享内容块，不拷贝）；已是视图时原样返回
+    ValueData MakeView(const ValueData &source);
+
+    // 逐行迭代器：next() 返回下一行的视图（去掉行尾的\n或\r\n，结束后返回Nil），done() 判断是否结束
+    class LineIterator : public ObjectData {
+      public:
+        explicit LineIterator(std::shared_ptr<const ByteView> source, std::string_view rest)
+            : source(std::move(source)), rest(rest) {}
+
+        std::string type_name() const override {
+            return "lines";
+        }
+
+        ValueData member(const std::string &name) override;
+
+      private:
+        std::shared_ptr<const ByteView> source;
+        std::string_view rest; // 尚未迭代的内容
+    };
+
+} // namespace squ
\ No newline at end of file
@@ -4,8 +4,51 @@
 #include <unordered_map>
 #include "identifier.h"
 
+// 原生模块的接口版本。共享库需要导出：
+//   extern "C" int squaker_module_abi();                          返回 SQUAKER_MODULE_ABI
+//   extern "C" void squaker_module_init(squ::IdentifierData *out); 写入模块的命名空间
+// 可以用 SQUAKER_MODULE(factory) 生成这两个函数（factory 返回 Namespace(...)）。
+// 共享库与宿主必须使用同一版本的头文件和兼容的编译器编译
+#define SQUAKER_MODULE_ABI 1
+
+#ifdef _WIN32
+#define SQUAKER_MODULE_EXPORT extern "C" __declspec(dllexport)
+#else
+#define SQUAKER_MODULE_EXPORT extern "C" __attribute__((visibility("default")))
+#endif
+
+#define SQUAKER_MODULE(factory)                                                                                    \
+    SQUAKER_MODULE_EXPORT int squaker_module_abi() {                                                               \
+        return SQUAKER_MODULE_ABI;                                                                                 \
+    }                                                                                                              \
+    SQUAKER_MODULE_EXPORT void squaker_module_init(squ::IdentifierData *out) {                                     \
+        *out = factory();                                                                                          \
+    }
+
 namespace squ {
 
+    // 模块工厂：模块第一次被导入时调用一次，返回模块的命名空间
+    using ModuleFactory = std::function<IdentifierData()>;
+
+    // 注册模块（同名模块已存在时抛出异常），模块在第一次导入时才构建
+    void RegisterModule(const std::string &module_name, ModuleFactory factory);
+
+    // 添加模块的查找目录（环境变量 SQUAKER_MODULE_PATH 中的目录也会被查找）：
+    // 未注册的模块在其中寻找共享库，相对路径的脚本模块在导入它的脚本所在目录中找不到时也在其中寻找
+    void AddModulePath(const std::string &directory);
+
+    // 从共享库加载原生模块，注册为 module_name
+    void LoadNativeModule(const std::string &module_name, const std::string &library_path);
+
     IdentifierData Module(std::string module_name);    // 注册模块
 
+    // 进程内共享的模块（首次使用时构建，返回的引用在进程结束前一直有效，不可修改）
+    // 以.sq结尾的名字是脚本模块：文件只解析、执行一次，顶层变量组成命名空间，按规范路径和修改时间缓存；
+    // 相对路径先相对 directory（导入它的脚本所在的目录，为空时是当前工作目录），再在查找目录中寻找。
+    // 未注册的其他模块会在查找目录中寻找同名的共享库（module_name.so / .dylib / .dll）
+    const ValueData &LoadModule(const std::string &module_name, const std::string &directory = "");
+
+    // 模块在脚本中绑定的名字（脚本模块为不含扩展名的文件名，不是合法标识符时抛出异常，需要用 import ... as name）
+    std::string ModuleBindingName(const std::string &module_name);
+
 } // namespace squ
\ No newline at end of file
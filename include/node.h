@@ -1,19 +1,27 @@
 #pragma once
 
+#include "operator.h"
 #include "type.h"
 #include "vm.h"
+#include <atomic>
+#include <cstdint>
 #include <memory>
 #include <string>
+#include <string_view>
 #include <unordered_map>
 #include <vector>
 
 namespace squ {
 
+    struct IntrinsicInfo; // 内建函数注册项（见 intrinsic.h）
+    struct NativeFunction; // 原生函数描述（见 identifier.h）
+
     // 节点类型枚举
     enum class NodeType {
         Literal,        // 字面量
         Identifier,     // 标识符
         BinaryOp,       // 二元操作
+        Logical,        // 逻辑与/或（短路求值）
         UnaryOp,        // 一元操作
         PostfixOp,      // 后缀操作
         Assignment,     // 赋值
@@ -28,11 +36,34 @@ namespace squ {
         ControlFlow,    // 控制流语句
         Return,         // 返回语句
         MemberAccess,   // 成员访问
+        ModuleMember,   // 解析期绑定的模块成员
         Index,          // 索引访问
+        Slice,          // 切片访问
         NativeCall,     // 原生函数调用
         Array,          // 数组
         Map,            // 映射表
-        Table           // 表
+        Table,          // 表
+        Spawn,          // 任务派生
+        Join,           // 任务汇合
+        Yield,          // 生成器产出
+        Record          // 记录构造
+    };
+
+    // 赋值、复合赋值与自增的目标位置：通常直接引用变量、数组元素或表成员；
+    // 目标是对象按下标读写的元素（如类型化数组的 a[i]）时，元素先读入 value，修改后由 commit 写回对象
+    struct Place {
+        ValueData *ref = nullptr;
+        std::shared_ptr<ObjectData> object;
+        long long at = 0;
+        ValueData value;
+
+        ValueData &get() {
+            return ref ? *ref : value;
+        }
+        void commit() {
+            if (object)
+                object->set_element(at, value);
+        }
     };
 
     class ExprNode {
@@ -45,6 +76,15 @@ namespace squ {
         virtual ValueData evaluate(VM &vm) const = 0;
         // 左值求值接口
         virtual ValueData &evaluate_lvalue(VM &vm) const = 0;
+        // 语句求值接口：结果不会被使用时调用，节点可以省去构造返回值
+        virtual void execute(VM &vm) const {
+            evaluate(vm);
+        }
+        // 条件求值接口：if与循环的条件直接取得真假，比较与逻辑节点不构造中间的布尔值
+        virtual bool evaluate_condition(VM &vm) const;
+        // 只读求值接口：返回值的只读引用（变量、表成员、数组元素本身，不拷贝）；
+        // 结果是新产生的值时存入scratch并返回它。引用只在下一次可能修改该值的求值之前有效
+        virtual const ValueData &evaluate_ref(VM &vm, ValueData &scratch) const;
         // 克隆接口，用于深拷贝
         virtual std::unique_ptr<ExprNode> clone() const = 0;
     };
@@ -56,13 +96,20 @@ namespace squ {
       public:
         explicit LiteralNode(ValueData data) : data(std::move(data)) {}
 
+        // 字面量的值（供解析期检查）
+        const ValueData &value() const {
+            return data;
+        }
+
         std::string string() const override;
         NodeType type() const override {
             return NodeType::Literal;
         }
         ValueData evaluate(VM &vm) const override;
         ValueData &evaluate_lvalue(VM &vm) const override;
+        const ValueData &evaluate_ref(VM &vm, ValueData &scratch) const override;
         std::unique_ptr<ExprNode> clone() const override;
+        bool evaluate_condition(VM &vm) const override;
     };
 
     // 标识符节点
@@ -72,12 +119,21 @@ namespace squ {
 
       public:
         explicit IdentifierNode(std::string id, size_t idx) : name(std::move(id)), index(idx) {}
+
+        // 变量名与所在的槽位
+        const std::string &identifier() const {
+            return name;
+        }
+        size_t slot() const {
+            return index;
+        }
         std::string string() const override;
         NodeType type() const override {
             return NodeType::Identifier;
         }
         ValueData evaluate(VM &vm) const override;
         ValueData &evaluate_lvalue(VM &vm) const override;
+        const ValueData &evaluate_ref(VM &vm, ValueData &scratch) const override;
         std::unique_ptr<ExprNode> clone() const override;
     };
 
@@ -102,6 +158,8 @@ namespace squ {
         std::string op;
         std::unique_ptr<ExprNode> left;
         std::unique_ptr<ExprNode> right;
+        bool comparison = false; // 是否为比较操作（作为条件时直接得到bool）
+        CompareOp compareOp = CompareOp::Eq;
 
       public:
         BinaryOpNode(std::string op, std::unique_ptr<ExprNode> l, std::unique_ptr<ExprNode> r);
@@ -113,6 +171,29 @@ namespace squ {
         ValueData evaluate(VM &vm) const override;
         ValueData &evaluate_lvalue(VM &vm) const override;
         std::unique_ptr<ExprNode> clone() const override;
+        bool evaluate_condition(VM &vm) const override;
+
+        // 连续拼接 a .. b .. c 的各个操作数（按求值顺序）；不是拼接时返回false
+        bool concat_operands(std::vector<const ExprNode *> &parts) const;
+    };
+
+    // 逻辑节点（&& 与 ||）：左操作数已能决定结果时不再求值右操作数
+    class LogicalNode : public ExprNode {
+        bool isAnd; // && 为true，|| 为false
+        std::unique_ptr<ExprNode> left;
+        std::unique_ptr<ExprNode> right;
+
+      public:
+        LogicalNode(const std::string &op, std::unique_ptr<ExprNode> l, std::unique_ptr<ExprNode> r);
+
+        std::string string() const override;
+        NodeType type() const override {
+            return NodeType::Logical;
+        }
+        ValueData evaluate(VM &vm) const override;
+        ValueData &evaluate_lvalue(VM &vm) const override;
+        std::unique_ptr<ExprNode> clone() const override;
+        bool evaluate_condition(VM &vm) const override;
     };
 
     // 一元操作节点（前缀）
@@ -129,6 +210,8 @@ namespace squ {
         }
         ValueData evaluate(VM &vm) const override;
         ValueData &evaluate_lvalue(VM &vm) const override;
+        void execute(VM &vm) const override;
+        bool evaluate_condition(VM &vm) const override;
         std::unique_ptr<ExprNode> clone() const override;
     };
 
@@ -146,6 +229,7 @@ namespace squ {
         }
         ValueData evaluate(VM &vm) const override;
         ValueData &evaluate_lvalue(VM &vm) const override;
+        void execute(VM &vm) const override;
         std::unique_ptr<ExprNode> clone() const override;
     };
 
@@ -164,7 +248,15 @@ namespace squ {
         }
         ValueData evaluate(VM &vm) const override;
         ValueData &evaluate_lvalue(VM &vm) const override;
+        void execute(VM &vm) const override;
         std::unique_ptr<ExprNode> clone() const override;
+
+      private:
+        // 执行赋值，返回被赋值的位置（对象元素没有位置，写入后的值放在 scratch 中）
+        ValueData &assign(VM &vm, ValueData &scratch) const;
+
+        // x = x .. a .. b 形式时为 a、b（原地追加到x），否则为空
+        std::vector<const ExprNode *> appendParts;
     };
 
     // 复合赋值节点（如 +=, -= 等）
@@ -182,7 +274,14 @@ namespace squ {
         }
         ValueData evaluate(VM &vm) const override;
         ValueData &evaluate_lvalue(VM &vm) const override;
+        void execute(VM &vm) const override;
         std::unique_ptr<ExprNode> clone() const override;
+
+      private:
+        // 执行复合赋值，返回被修改的位置（对象元素没有位置，写回的值放在 scratch 中）
+        ValueData &assign(VM &vm, ValueData &scratch) const;
+
+        std::string binaryOp; // 对应的二元操作符（+= 为 +）
     };
 
     // Lambda节点（函数定义）
@@ -192,13 +291,32 @@ namespace squ {
         Parameter() = default;
         Parameter(std::string n, size_t s) : name(std::move(n)), slot(s) {}
     };
+
+    // 脚本函数：LambdaNode 求值得到的可调用对象。函数体与参数表由所有副本共享，拷贝函数值只增加引用计数；
+    // 调用点取出它后直接进入函数体，不经过 std::function 的间接调用
+    struct ScriptFunction {
+        struct Code {
+            std::shared_ptr<ExprNode> body;
+            std::vector<Parameter> parameters;
+            size_t maxSlot = 0; // 局部变量总数
+        };
+        std::shared_ptr<const Code> code;
+
+        // 在新帧中执行函数体：args 指向 count 个实参，归本次调用所有，直接移入参数槽位
+        static ValueData invoke(const Code &code, ValueData *args, size_t count, VM &vm);
+
+        ValueData operator()(std::vector<ValueData> &args, VM &vm) const {
+            return invoke(*code, args.data(), args.size(), vm);
+        }
+    };
     class LambdaNode : public ExprNode {
         std::vector<Parameter> parameters;
         std::shared_ptr<ExprNode> body;
         size_t maxSlot = 0; // 局部变量总数
+        bool generator = false; // 函数体含yield时，调用返回生成器对象
 
       public:
-        LambdaNode(std::vector<Parameter> params, std::unique_ptr<ExprNode> b);
+        LambdaNode(std::vector<Parameter> params, std::unique_ptr<ExprNode> b, size_t slots, bool gen = false);
 
         std::string string() const override;
         NodeType type() const override {
@@ -213,6 +331,12 @@ namespace squ {
     class ApplyNode : public ExprNode {
         std::unique_ptr<ExprNode> callee;
         std::vector<std::unique_ptr<ExprNode>> arguments;
+        uint64_t pathArgs = 0; // 是只读路径的实参（调用原生函数时借用而不拷贝）
+
+        // 被调函数是解析期绑定的模块成员时（只读且与进程同寿命），构造时就取出调用入口，调用时直接进入。
+        // 其他被调函数每次调用时取出（变量的值可能随时改变，没有不经类型探测就能核对的标识）
+        const ScriptFunction::Code *boundCode = nullptr;
+        const NativeFunction *boundNative = nullptr;
 
       public:
         ApplyNode(std::unique_ptr<ExprNode> callee, std::vector<std::unique_ptr<ExprNode>> args);
@@ -224,6 +348,14 @@ namespace squ {
         ValueData evaluate(VM &vm) const override;
         ValueData &evaluate_lvalue(VM &vm) const override;
         std::unique_ptr<ExprNode> clone() const override;
+
+        // 求值被调函数与实参，但不发起调用（供spawn延迟执行）
+        void prepare_call(VM &vm, ValueData &calleeVal, std::vector<ValueData> &argValues) const;
+
+      private:
+        // 调用脚本函数：pin 在调用期间持有函数代码（被调函数是模块成员时为空）
+        ValueData call_script(std::shared_ptr<const ScriptFunction::Code> pin, const ScriptFunction::Code &code,
+                              VM &vm) const;
     };
 
     // 条件节点（if-else if-else）
@@ -241,6 +373,7 @@ namespace squ {
         }
         ValueData evaluate(VM &vm) const override;
         ValueData &evaluate_lvalue(VM &vm) const override;
+        void execute(VM &vm) const override;
         std::unique_ptr<ExprNode> clone() const override;
     };
 
@@ -249,6 +382,22 @@ namespace squ {
         std::unique_ptr<ExprNode> expression; // switch表达式
         std::vector<std::pair<std::unique_ptr<ExprNode>, std::unique_ptr<ExprNode>>> cases; // (case条件, 结果) 对
         std::unique_ptr<ExprNode> defaultCase; // 可选的default分支
+        bool pathCases = true;                 // case值都是只读路径（求值不会修改switch的值，可以借用）
+
+        // case值全部是常量时在构造时建立的分派表，按switch的值直接查出分支，不再逐个比较
+        struct CaseTable {
+            static constexpr size_t npos = static_cast<size_t>(-1);
+
+            long long base = 0;                                  // 密集整数表的最小值
+            std::vector<size_t> dense;                           // 整数值较密集时：值-base → 分支下标
+            std::vector<std::pair<long long, size_t>> sorted;    // 整数值稀疏时：按值排序，二分查找
+            std::unordered_map<StringData, size_t, StringData::Hash> strings; // 字符串：按缓存的哈希值查找，驻留的字面量只比较地址
+            std::vector<std::pair<const ValueData *, size_t>> others; // 其他类型：顺序比较
+
+            // 查找与value相等的第一个case，没有时返回npos
+            size_t find(const ValueData &value) const;
+        };
+        std::unique_ptr<CaseTable> caseTable; // case值不全是常量时为空，按顺序求值比较
 
       public:
         SwitchNode(std::unique_ptr<ExprNode> expr,
@@ -261,7 +410,12 @@ namespace squ {
         }
         ValueData evaluate(VM &vm) const override;
         ValueData &evaluate_lvalue(VM &vm) const override;
+        void execute(VM &vm) const override;
         std::unique_ptr<ExprNode> clone() const override;
+
+      private:
+        // 选出要执行的分支并给出它的恢复位置，没有匹配的分支时返回空
+        const ExprNode *select(VM &vm, Coroutine *co, size_t &point) const;
     };
 
     // For循环节点
@@ -281,7 +435,12 @@ namespace squ {
         }
         ValueData evaluate(VM &vm) const override;
         ValueData &evaluate_lvalue(VM &vm) const override;
+        void execute(VM &vm) const override;
         std::unique_ptr<ExprNode> clone() const override;
+
+      private:
+        // 执行循环：result非空时循环体按表达式求值并留下最后一次的结果，否则循环体以语句方式执行
+        void run(VM &vm, ValueData *result) const;
     };
 
     // 块节点（用于多语句）
@@ -297,6 +456,7 @@ namespace squ {
         }
         ValueData evaluate(VM &vm) const override;
         ValueData &evaluate_lvalue(VM &vm) const override;
+        void execute(VM &vm) const override;
         std::unique_ptr<ExprNode> clone() const override;
     };
 
@@ -314,7 +474,12 @@ namespace squ {
         }
         ValueData evaluate(VM &vm) const override;
         ValueData &evaluate_lvalue(VM &vm) const override;
+        void execute(VM &vm) const override;
         std::unique_ptr<ExprNode> clone() const override;
+
+      private:
+        // 执行循环：result非空时循环体按表达式求值并留下最后一次的结果，否则循环体以语句方式执行
+        void run(VM &vm, ValueData *result) const;
     };
 
     // Do-while循环节点
@@ -331,7 +496,12 @@ namespace squ {
         }
         ValueData evaluate(VM &vm) const override;
         ValueData &evaluate_lvalue(VM &vm) const override;
+        void execute(VM &vm) const override;
         std::unique_ptr<ExprNode> clone() const override;
+
+      private:
+        // 执行循环：result非空时循环体按表达式求值并留下最后一次的结果，否则循环体以语句方式执行
+        void run(VM &vm, ValueData *result) const;
     };
 
     // 模块导入节点
@@ -386,16 +556,70 @@ namespace squ {
     class MemberAccessNode : public ExprNode {
         std::unique_ptr<ExprNode> object;
         std::string member;
+        Symbol symbol; // 驻留的成员名：缓存未命中时按地址比较查找槽位
+
+        // 单态内联缓存：高32位为上次见到的形状编号，低32位为成员所在槽位（0表示尚未缓存）。
+        // 形状永不释放且编号不复用，打包在一个原子字里，多个线程执行同一节点时不需要加锁
+        mutable std::atomic<uint64_t> cache{0};
+
+        // 多态回退：单态缓存未命中若干次后，不再改写单态缓存，新见到的形状依次放入这几个条目（编码同上）
+        static constexpr size_t kPolymorphicEntries = 4;
+        static constexpr uint32_t kMonomorphicMisses = 2;
+        mutable std::atomic<uint64_t> polymorphic[kPolymorphicEntries] = {};
+        mutable std::atomic<uint32_t> misses{0};
+
+        // 成员在给定形状中的槽位，不存在时返回TableTableShape::npos
+        size_t slot_in(const TableShape &shape) const;
 
       public:
         MemberAccessNode(std::unique_ptr<ExprNode> obj, std::string mem);
 
+        // 被访问的对象与成员名（供解析期解析模块成员）
+        const ExprNode &target() const {
+            return *object;
+        }
+        const std::string &member_name() const {
+            return member;
+        }
+
+        // 解析期按声明的记录类型预置缓存：成员是该记录的字段时，第一次访问就直接命中槽位
+        void bind(const TableShape &shape);
+
         std::string string() const override;
         NodeType type() const override {
             return NodeType::MemberAccess;
         }
         ValueData evaluate(VM &vm) const override;
         ValueData &evaluate_lvalue(VM &vm) const override;
+        const ValueData &evaluate_ref(VM &vm, ValueData &scratch) const override;
+        std::unique_ptr<ExprNode> clone() const override;
+    };
+
+    // 模块成员节点：导入的模块在进程内共享且不可修改，module.member 在解析期直接绑定到成员本身
+    class ModuleMemberNode : public ExprNode {
+        std::string module;
+        std::string member;
+        const ValueData *data; // 指向共享模块中的成员（与进程同寿命）
+
+      public:
+        ModuleMemberNode(std::string module, std::string member, const ValueData *data);
+
+        // 绑定的成员值（调用时直接引用，不拷贝）
+        const ValueData &value() const {
+            return *data;
+        }
+        // 限定名 module.member
+        std::string qualified_name() const {
+            return module + "." + member;
+        }
+
+        std::string string() const override;
+        NodeType type() const override {
+            return NodeType::ModuleMember;
+        }
+        ValueData evaluate(VM &vm) const override;
+        ValueData &evaluate_lvalue(VM &vm) const override;
+        const ValueData &evaluate_ref(VM &vm, ValueData &scratch) const override;
         std::unique_ptr<ExprNode> clone() const override;
     };
 
@@ -403,26 +627,58 @@ namespace squ {
     class IndexNode : public ExprNode {
         std::unique_ptr<ExprNode> container;
         std::unique_ptr<ExprNode> index;
+        bool pathContainer; // 容器是只读路径（求值不会修改下标的值，下标可以借用）
 
       public:
         IndexNode(std::unique_ptr<ExprNode> cont, std::unique_ptr<ExprNode> idx);
 
+        // 被索引的容器与下标表达式
+        const ExprNode &target() const {
+            return *container;
+        }
+        const ExprNode &key() const {
+            return *index;
+        }
+
+        // 赋值目标：容器是按下标读写元素的对象时，元素读入返回值中，修改后写回
+        Place place(VM &vm) const;
+
         std::string string() const override;
         NodeType type() const override {
             return NodeType::Index;
         }
         ValueData evaluate(VM &vm) const override;
         ValueData &evaluate_lvalue(VM &vm) const override;
+        const ValueData &evaluate_ref(VM &vm, ValueData &scratch) const override;
+        std::unique_ptr<ExprNode> clone() const override;
+    };
+
+    // 切片节点 a[start:end]（两端可省略，分别默认为开头和结尾）
+    class SliceNode : public ExprNode {
+        std::unique_ptr<ExprNode> container;
+        std::unique_ptr<ExprNode> start;
+        std::unique_ptr<ExprNode> end;
+
+      public:
+        SliceNode(std::unique_ptr<ExprNode> cont, std::unique_ptr<ExprNode> s, std::unique_ptr<ExprNode> e);
+
+        std::string string() const override;
+        NodeType type() const override {
+            return NodeType::Slice;
+        }
+        ValueData evaluate(VM &vm) const override;
+        ValueData &evaluate_lvalue(VM &vm) const override;
         std::unique_ptr<ExprNode> clone() const override;
     };
 
-    // 原生函数调用节点
+    // 原生函数调用节点（@name(...)，内建函数在解析期从注册表中查得）
     class NativeCallNode : public ExprNode {
-        std::string functionName;
+        const IntrinsicInfo *intrinsic;
         std::vector<std::unique_ptr<ExprNode>> arguments;
+        uint64_t pathArgs = 0; // 是只读路径的实参（借用而不拷贝）
 
       public:
-        NativeCallNode(std::string name, std::vector<std::unique_ptr<ExprNode>> args);
+        NativeCallNode(const IntrinsicInfo *intrinsic, std::vector<std::unique_ptr<ExprNode>> args);
 
         std::string string() const override;
         NodeType type() const override {
@@ -454,6 +710,10 @@ namespace squ {
         std::vector<std::pair<std::unique_ptr<ExprNode>, std::unique_ptr<ExprNode>>> members;
         std::vector<std::unique_ptr<ExprNode>> elements;
 
+        // 成员名都是字符串字面量时在构造时确定形状，求值时直接按槽位写入（否则为空）
+        const TableShape *shape = nullptr;
+        std::vector<size_t> memberSlots; // 各成员对应的槽位
+
       public:
         explicit TableNode(std::vector<std::pair<std::unique_ptr<ExprNode>, std::unique_ptr<ExprNode>>> entries,
                            std::vector<std::pair<std::unique_ptr<ExprNode>, std::unique_ptr<ExprNode>>> members,
@@ -468,4 +728,71 @@ namespace squ {
         std::unique_ptr<ExprNode> clone() const override;
     };
 
+    // 记录构造节点（Point(x, y, z)）：形状在声明时确定，字段值按声明顺序直接写入槽位
+    class RecordNode : public ExprNode {
+        const TableShape *shape;
+        std::vector<std::unique_ptr<ExprNode>> fields;
+
+      public:
+        RecordNode(const TableShape *shape, std::vector<std::unique_ptr<ExprNode>> fields);
+
+        std::string string() const override;
+        NodeType type() const override {
+            return NodeType::Record;
+        }
+        ValueData evaluate(VM &vm) const override;
+        ValueData &evaluate_lvalue(VM &vm) const override;
+        std::unique_ptr<ExprNode> clone() const override;
+    };
+
+    // 任务派生节点（spawn f(args)）
+    class SpawnNode : public ExprNode {
+        std::unique_ptr<ApplyNode> call;
+
+      public:
+        explicit SpawnNode(std::unique_ptr<ApplyNode> c);
+
+        std::string string() const override;
+        NodeType type() const override {
+            return NodeType::Spawn;
+        }
+        ValueData evaluate(VM &vm) const override;
+        ValueData &evaluate_lvalue(VM &vm) const override;
+        std::unique_ptr<ExprNode> clone() const override;
+    };
+
+    // 任务汇合节点（join(h)）
+    class JoinNode : public ExprNode {
+        std::unique_ptr<ExprNode> handle;
+
+      public:
+        explicit JoinNode(std::unique_ptr<ExprNode> h);
+
+        std::string string() const override;
+        NodeType type() const override {
+            return NodeType::Join;
+        }
+        ValueData evaluate(VM &vm) const override;
+        ValueData &evaluate_lvalue(VM &vm) const override;
+        std::unique_ptr<ExprNode> clone() const override;
+    };
+
+    // 生成器产出节点（yield expr）
+    // 挂起时抛出YieldException，恢复时直接返回next()传入的值；
+    // 同一表达式中位于yield左侧的操作数在恢复时会被重新求值，因此yield宜作为语句或赋值右侧使用
+    class YieldNode : public ExprNode {
+        std::unique_ptr<ExprNode> value;
+
+      public:
+        explicit YieldNode(std::unique_ptr<ExprNode> val);
+
+        std::string string() const override;
+        NodeType type() const override {
+            return NodeType::Yield;
+        }
+        ValueData evaluate(VM &vm) const override;
+        ValueData &evaluate_lvalue(VM &vm) const override;
+        std::unique_ptr<ExprNode> clone() const override;
+    };
+
 } // namespace squ
\ No newline at end of file
@@ -11,10 +11,44 @@ namespace squ {
                           const std::string &op,
                           const ValueData &rhs);
 
+    // 条件的真假：nil、false、整数0与实数0.0为假，其他值为真
+    inline bool IsTruthy(const ValueData &value) {
+        switch (value.type) {
+            case ValueType::Nil:
+                return false;
+            case ValueType::Bool:
+                return std::get<bool>(value.value);
+            case ValueType::Integer:
+                return std::get<long long>(value.value) != 0;
+            case ValueType::Real:
+                return std::get<double>(value.value) != 0.0;
+            default:
+                return true;
+        }
+    }
+
+    // 比较操作符
+    enum class CompareOp { Eq, Ne, Lt, Le, Gt, Ge };
+
+    // 解析比较操作符，不是比较时返回false
+    bool ParseCompareOp(const std::string &op, CompareOp &result);
+
+    // 比较并直接得到bool（数值比较不构造中间的ValueData），结果与 ApplyBinary 作为条件时一致
+    bool ApplyCompare(const ValueData &lhs, CompareOp op, const ValueData &rhs);
+
+    // 按 .. 的规则把值追加到字符串末尾（字符串与字节视图取原内容，其他值取字符串表示）
+    void AppendConcat(std::string &out, const ValueData &value);
+
     // 应用一元操作
     // op: 操作符, operand: 操作数
     ValueData ApplyUnary(const std::string &op, const ValueData &operand);
 
+    // 复合赋值：按 binaryOp 原地修改 place（整数、实数的算术与位运算直接改写，其余按 ApplyBinary 计算后写回）
+    void ApplyCompound(ValueData &place, const std::string &binaryOp, const ValueData &rhs);
+
+    // 自增/自减：原地给整数或实数加上 delta
+    void ApplyIncrement(ValueData &place, long long delta);
+
     // 应用后缀操作
     // op: 操作符, operand: 操作数
     ValueData ApplyPostfix(const std::string &op, ValueData &operand);
@@ -0,0 +1,125 @@
+#pragma once
+#include "type.h"
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <string_view>
+
+namespace squ {
+
+    // 输出接收端：缓冲区刷新时一次收到整块数据，宿主可替换（如写入文件描述符或内存）
+    class OutputSink {
+      public:
+        virtual ~OutputSink() = default;
+        virtual void write(const char *data, size_t size) = 0;
+
+        // 把已写入的数据推到底层（显式刷新与虚拟机结束时调用）
+        virtual void flush() {}
+
+        // 同一接收端可能被多个线程上的虚拟机共享（派生的任务写入派生它的虚拟机的接收端），
+        // OutputBuffer 持有这把锁整块写出；不同接收端互不影响
+        std::mutex mutex;
+    };
+
+    // 写入C++输出流（默认为std::cout）
+    class StreamSink : public OutputSink {
+      public:
+        explicit StreamSink(std::ostream &os) : os(os) {}
+        void write(const char *data, size_t size) override;
+        void flush() override;
+
+      private:
+        std::ostream &os;
+    };
+
+    // 直接写入文件描述符
+    class FdSink : public OutputSink {
+      public:
+        explicit FdSink(int fd) : fd(fd) {}
+        void write(const char *data, size_t size) override;
+
+      private:
+        int fd;
+    };
+
+    // 写入内存（便于测试时捕获输出）
+    class MemorySink : public OutputSink {
+      public:
+        void write(const char *data, size_t size) override {
+            text.append(data, size);
+        }
+        std::string text;
+    };
+
+    // 输出缓冲区：每个虚拟机一个，值直接格式化进缓冲区，
+    // 超过上限、遇到换行且为行缓冲模式、或显式flush时才交给接收端；只有显式flush（和析构）会刷新接收端
+    class OutputBuffer {
+      public:
+        static constexpr size_t kDefaultLimit = 64 * 1024;
+
+        // 默认写入std::cout；标准输出是终端时按行刷新
+        OutputBuffer();
+        ~OutputBuffer();
+        OutputBuffer(const OutputBuffer &) = delete;
+        OutputBuffer &operator=(const OutputBuffer &) = delete;
+
+        // 替换接收端（会先刷新已有内容）
+        void set_sink(std::shared_ptr<OutputSink> newSink);
+
+        // 当前的接收端
+        const std::shared_ptr<OutputSink> &get_sink() const {
+            return sink;
+        }
+
+        // 刷新已有内容后换上另一个接收端并返回原来的（不改变刷新策略，用于临时借用其他接收端）
+        std::shared_ptr<OutputSink> exchange_sink(std::shared_ptr<OutputSink> newSink);
+
+        // 缓冲上限（字节）
+        void set_limit(size_t bytes) {
+            limit = bytes;
+        }
+
+        // 是否每行刷新
+        void set_line_buffered(bool enabled) {
+            lineBuffered = enabled;
+        }
+
+        // 追加原始文本
+        void write(std::string_view text);
+
+        // 追加单个字符
+        void put(char c) {
+            buffer.push_back(c);
+        }
+
+        // 按ValueData::string()的格式直接写入值，不产生临时字符串
+        void format(const ValueData &value);
+
+        // 结束一行：写入换行并按策略刷新
+        void newline();
+
+        // 交给接收端并刷新接收端
+        void flush();
+
+      private:
+        // 交给接收端（不刷新接收端）
+        void drain();
+
+        // 递归格式化
+        void format_into(const ValueData &value);
+
+        // 超过上限时刷新
+        void maybe_flush() {
+            if (buffer.size() >= limit)
+                drain();
+        }
+
+        std::shared_ptr<OutputSink> sink;
+        std::string buffer;
+        size_t limit = kDefaultLimit;
+        bool lineBuffered = false;
+    };
+
+} // namespace squ
\ No newline at end of file
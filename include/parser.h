@@ -1,5 +1,6 @@
 #pragma once
 
+#include "identifier.h"
 #include "node.h"
 #include "scope.h"
 #include "token.h"
@@ -8,6 +9,7 @@
 #include <stack>
 #include <stdexcept>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 namespace squ {
@@ -18,6 +20,11 @@ namespace squ {
         size_t current = 0;
         std::unique_ptr<Scope> curScope;
         std::stack<std::unique_ptr<Scope>> scopeStack;
+        bool sawYield = false; // 当前函数体中是否出现过yield（决定是否为生成器）
+        std::unordered_map<size_t, const ValueData *> imports; // 当前函数作用域中导入的共享模块（按槽位）
+        std::unordered_map<std::string, const TableShape *> records; // 已声明的记录类型（在所有作用域可见）
+        std::unordered_map<std::string, const TableShape *> recordFields; // 字段名到最先声明它的记录类型
+        std::string directory; // 所解析脚本所在的目录，导入脚本模块时相对路径以它为基准（为空时是当前工作目录）
 
         // 默认构造函数
         Parser();
@@ -83,6 +90,13 @@ namespace squ {
         // 解析函数调用
         std::unique_ptr<ExprNode> parse_function_call(std::unique_ptr<ExprNode> callee);
 
+        // 解析期可以确定的值（当前函数作用域中导入模块的成员），无法确定时返回空（返回的指针与进程同寿命）
+        const ValueData *resolve_static(const ExprNode &expr) const;
+
+        // 解析期检查原生函数调用的参数个数与字面量参数的类型
+        void check_native_call(const std::string &callee, const NativeFunction &native,
+                               const std::vector<std::unique_ptr<ExprNode>> &arguments) const;
+
         // 解析块表达式（多语句）
         std::unique_ptr<ExprNode> parse_block();
 
@@ -113,9 +127,24 @@ namespace squ {
         // 解析导入语句
         std::unique_ptr<ExprNode> parse_import_statement();
 
+        // 解析记录类型声明（record Name { field, ... }）
+        std::unique_ptr<ExprNode> parse_record_declaration();
+
+        // 解析记录类型名的使用：Name(...) 构造记录，单独出现时是构造函数
+        std::unique_ptr<ExprNode> parse_record_construction(const TableShape &shape);
+
         // 解析return语句
         std::unique_ptr<ExprNode> parse_return_statement();
 
+        // 解析yield语句
+        std::unique_ptr<ExprNode> parse_yield_statement();
+
+        // 解析spawn表达式
+        std::unique_ptr<ExprNode> parse_spawn_expression();
+
+        // 解析join表达式
+        std::unique_ptr<ExprNode> parse_join_expression();
+
         // 解析原生函数调用
         std::unique_ptr<ExprNode> parse_native_call(const std::string &functionName);
 
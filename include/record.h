@@ -0,0 +1,52 @@
+#pragma once
+#include "type.h"
+#include "vm.h"
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace squ {
+
+    // 记录类型（record Name { ... }）的构造函数：按声明顺序接收字段值，缺少的字段为Nil
+    struct RecordConstructor {
+        const TableShape *shape;
+
+        ValueData operator()(std::vector<ValueData> &args, VM &vm) const;
+    };
+
+    // 包装为脚本值
+    ValueData MakeRecordConstructor(const TableShape &shape);
+
+    // 取出函数值中的记录类型（不是记录构造函数时返回空）
+    const TableShape *AsRecord(const ValueData &function);
+
+    // 记录数组：按字段分列存放（struct-of-arrays），同一字段的值连续存放，
+    // 逐字段扫描时不经过每条记录的表头。不是线程安全的，不要在多个任务间共享
+    // 成员：length() get(i) set(i, r) push(r) load(i, field) store(i, field, v) column(field)
+    class RecordArray : public ObjectData {
+      public:
+        RecordArray(const TableShape &shape, size_t length);
+
+        std::string type_name() const override {
+            return "recordarray";
+        }
+
+        std::string string() const override;
+
+        ValueData member(const std::string &name) override;
+
+        // 取出第i条记录（重新组装成记录实例）
+        ValueData get(size_t i) const;
+
+        // 写入第i条记录（接受同类型的记录或含有全部字段的表）
+        void set(size_t i, const ValueData &record);
+
+        // 字段所在的列，不存在时抛出异常
+        size_t field(const std::string &name) const;
+
+        const TableShape &shape;
+        std::vector<std::vector<ValueData>> columns; // 每个字段一列
+        size_t length = 0;
+    };
+
+} // namespace squ
\ No newline at end of file
@@ -1,6 +1,7 @@
 #pragma once
 #include <memory>
 #include <string>
+#include <utility>
 #include <vector>
 #include <unordered_map>
 
@@ -35,6 +36,9 @@ namespace squ {
         // 获取当前作用域的变量数量
         size_t size() const;
 
+        // 最外层块中声明的变量（名字与slot）
+        std::vector<std::pair<std::string, size_t>> bindings() const;
+
       private:
         std::vector<std::string> vars_;  // 保留变量名，方便调试
         std::vector<std::unordered_map<std::string, size_t>> blockStack; // 栈管理每个块的变量
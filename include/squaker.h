@@ -3,6 +3,8 @@
 #include "type.h"
 #include "vm.h"
 #include "identifier.h"
+#include "intrinsic.h"
+#include <memory>
 #include <string>
 
 namespace squ {
@@ -43,6 +45,12 @@ namespace squ {
         // 解析并执行脚本
         ValueData execute(const std::string& code = "");
 
+        // 解析并执行脚本文件（其中相对路径的脚本模块相对该文件所在的目录导入）
+        ValueData execute_file(const std::string &file_path);
+
+        // 设置输出接收端（默认为标准输出）
+        void set_output(std::shared_ptr<OutputSink> sink);
+
       private:
         std::vector<std::string> code; // 代码
         size_t current_index = 0;      // 当前代码索引
@@ -0,0 +1,117 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <string_view>
+
+namespace squ {
+
+    // 驻留的名字（成员名、记录字段名）：同一内容在进程内只保存一份且永不释放，
+    // 两个符号相等当且仅当地址相同，哈希值在驻留时算好
+    class Symbol {
+      public:
+        struct Entry {
+            std::string text;
+            size_t hash;
+        };
+
+        // 驻留名字（加锁查找驻留表，应在解析期或形状转移等低频路径上调用）
+        explicit Symbol(const std::string &text);
+
+        const std::string &str() const {
+            return entry->text;
+        }
+
+        size_t hash() const {
+            return entry->hash;
+        }
+
+        bool operator==(Symbol other) const {
+            return entry == other.entry;
+        }
+        bool operator!=(Symbol other) const {
+            return entry != other.entry;
+        }
+
+        // 供无序容器使用（直接取驻留时算好的哈希值）
+        struct Hash {
+            size_t operator()(Symbol symbol) const {
+                return symbol.hash();
+            }
+        };
+
+      private:
+        const Entry *entry;
+    };
+
+    // 字符串值：内容放在引用计数的共享块中，拷贝只复制指针，块中缓存算好的哈希值。
+    // 字符串字面量在解析期驻留，同一内容的字面量共享同一块；相等比较先比较地址，
+    // 两边的哈希值都已算出且不同时不再比较内容。修改前若内容被共享（或已驻留）先复制一份。
+    // 子串可以是切片：块中只记下源块与其中的一段，不复制内容（源块因此保持不变直到切片释放）
+    class StringData {
+      public:
+        StringData() = default;
+        StringData(std::string text);
+        StringData(std::string_view text) : StringData(std::string(text)) {}
+        StringData(const char *text) : StringData(std::string(text)) {}
+
+        // 驻留的字符串（加锁查找驻留表，只在解析期对字面量调用；驻留的内容永不释放）
+        static StringData intern(std::string_view text);
+
+        // 子串[start, end)（调用方检查范围）：较短的直接复制，否则与本串共享内容
+        StringData slice(size_t start, size_t end) const;
+
+        std::string_view view() const {
+            if (!rep)
+                return {};
+            return rep->base ? rep->part : std::string_view(rep->text);
+        }
+        size_t size() const {
+            return view().size();
+        }
+
+        // 以std::string形式引用内容：切片先换成独立的一份
+        const std::string &flat();
+
+        // 内容所在块的所有者（字节视图借此共享内容；持有期间修改会先复制）
+        std::shared_ptr<const void> owner() const {
+            return rep;
+        }
+
+        // 可修改的内容：独占时原地修改，否则先复制；修改后缓存的哈希值作废
+        std::string &edit();
+
+        // 内容的哈希值（与 std::hash<std::string_view> 一致），第一次使用时计算并缓存
+        size_t hash() const;
+
+        bool operator==(const StringData &other) const;
+        bool operator!=(const StringData &other) const {
+            return !(*this == other);
+        }
+        bool operator<(const StringData &other) const {
+            return rep != other.rep && view() < other.view();
+        }
+
+        // 供无序容器使用（直接取缓存的哈希值）
+        struct Hash {
+            size_t operator()(const StringData &text) const {
+                return text.hash();
+            }
+        };
+
+      private:
+        struct Rep {
+            std::string text;
+            mutable std::atomic<size_t> hash{0}; // 0表示尚未计算
+            bool interned = false;               // 驻留的内容不可修改
+            std::shared_ptr<const Rep> base;     // 切片的源块（不为空时内容是part，text不用）
+            std::string_view part;
+
+            explicit Rep(std::string text) : text(std::move(text)) {}
+        };
+
+        std::shared_ptr<Rep> rep; // 空字符串可以不分配
+    };
+
+} // namespace squ
\ No newline at end of file
@@ -0,0 +1,141 @@
+#pragma once
+#include "type.h"
+#include "vm.h"
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace squ {
+
+    // 任务对象：spawn 返回的句柄，join 时取回结果
+    // 捕获语义：被调函数与实参在派生线程上求值后按值拷贝进任务，数组与表逐元素拷贝，
+    // 字符串共享只读内容（修改前复制），脚本函数只引用不可变的语法树。
+    // 对象类型不做深拷贝，任务与派生方引用同一个对象：类型化数组、字符串构建器、记录数组、生成器等
+    // 都没有加锁，不能在派生方与任务（或多个任务）之间同时使用，其中任何一方修改时另一方都不能访问；
+    // 任务句柄、字节视图这类创建后不再改变的对象可以放心共享。
+    class TaskData : public ObjectData {
+      public:
+        TaskData(ValueData callee, std::vector<ValueData> args, std::shared_ptr<OutputSink> sink)
+            : callee(std::move(callee)), args(std::move(args)), sink(std::move(sink)) {}
+
+        std::string type_name() const override {
+            return "task";
+        }
+
+        // 在给定虚拟机上执行（函数调用会在其栈上压入独立的帧段）
+        void run(VM &vm);
+
+        // 是否已经执行完毕
+        bool done() const {
+            return finished.load(std::memory_order_acquire);
+        }
+
+        // 取回结果（任务抛出的异常在此重新抛出）
+        ValueData result() const;
+
+      private:
+        friend class Scheduler;
+
+        ValueData callee;
+        std::vector<ValueData> args;
+        std::shared_ptr<OutputSink> sink; // 派生它的虚拟机的输出接收端，任务的输出写到这里
+        ValueData value;
+        std::exception_ptr error;
+        std::atomic<bool> finished{false};
+        std::mutex mutex;                    // 与 doneSignal 配合，等待任务完成
+        std::condition_variable doneSignal;  // 任务完成时通知阻塞在 join 上的线程
+        std::shared_ptr<TaskData> keepAlive; // 排队期间由调度器持有的引用
+    };
+
+    // Chase-Lev 工作窃取双端队列：所有者在底部压入/弹出，窃取者从顶部取
+    class WorkStealingDeque {
+      public:
+        explicit WorkStealingDeque(size_t capacity = 64);
+        ~WorkStealingDeque();
+        WorkStealingDeque(const WorkStealingDeque &) = delete;
+        WorkStealingDeque &operator=(const WorkStealingDeque &) = delete;
+
+        // 所有者线程：压入底部
+        void push(TaskData *task);
+
+        // 所有者线程：从底部弹出
+        TaskData *pop();
+
+        // 任意线程：从顶部窃取
+        TaskData *steal();
+
+      private:
+        struct Buffer {
+            size_t mask;
+            std::unique_ptr<std::atomic<TaskData *>[]> slots;
+            explicit Buffer(size_t capacity) : mask(capacity - 1), slots(new std::atomic<TaskData *>[capacity]) {}
+            size_t capacity() const {
+                return mask + 1;
+            }
+            TaskData *get(int64_t i) const {
+                return slots[static_cast<size_t>(i) & mask].load(std::memory_order_relaxed);
+            }
+            void put(int64_t i, TaskData *task) {
+                slots[static_cast<size_t>(i) & mask].store(task, std::memory_order_relaxed);
+            }
+        };
+
+        // 扩容：旧缓冲区保留到析构，窃取者可能仍在读取
+        Buffer *grow(Buffer *old, int64_t bottom, int64_t top);
+
+        std::atomic<int64_t> top{0};
+        std::atomic<int64_t> bottom{0};
+        std::atomic<Buffer *> buffer;
+        std::vector<std::unique_ptr<Buffer>> retired;
+    };
+
+    // 工作窃取调度器：每个工作线程一个双端队列和一台虚拟机
+    class Scheduler {
+      public:
+        // 进程级单例，首次派生任务时启动工作线程
+        static Scheduler &instance();
+
+        ~Scheduler();
+
+        // 提交任务：工作线程压入自己的队列，其他线程进入注入队列
+        void submit(const std::shared_ptr<TaskData> &task);
+
+        // 等待任务完成；等待期间当前线程先执行自己队列中的任务，嵌套帮助不超过 kMaxHelpDepth 层时
+        // 也会窃取其他任务，否则阻塞直到任务完成（帮助执行的任务可能再次 join，限制层数避免栈溢出）
+        ValueData join(TaskData &task, VM &vm);
+
+        static constexpr size_t kMaxHelpDepth = 8;
+
+      private:
+        struct Worker {
+            WorkStealingDeque deque;
+            VM vm;
+            std::thread thread;
+        };
+
+        Scheduler();
+
+        // 工作线程主循环
+        void worker_loop(size_t index);
+
+        // 寻找可执行的任务：注入队列或窃取其他工作线程
+        TaskData *find_work(size_t self);
+
+        // 执行任务并释放调度器持有的引用
+        void execute(TaskData *task, VM &vm);
+
+        std::vector<std::unique_ptr<Worker>> workers;
+        std::deque<TaskData *> injected; // 非工作线程提交的任务
+        std::mutex mutex;
+        std::condition_variable wakeup;
+        std::atomic<size_t> pending{0};
+        std::atomic<bool> stopping{false};
+    };
+
+} // namespace squ
\ No newline at end of file
@@ -1,7 +1,12 @@
 #pragma once
 
+#include "symbol.h"
+#include <cstddef>
+#include <cstdint>
 #include <functional>
 #include <map>
+#include <memory>
+#include <mutex>
 #include <string>
 #include <string_view>
 #include <unordered_map>
@@ -20,28 +25,194 @@ namespace squ {
         String,   // 字符串
         Function, // 函数
         Array,    // 数组
-        Table     // 表
+        Table,    // 表
+        Object    // 对象（任务句柄等宿主类型）
     };
 
+    // 类型名（与 @type 的结果一致，对象统一为"object"）
+    const char *TypeName(ValueType type);
+
     // 前向声明
     class VM;
     struct ValueData;
+    struct ObjectData;
+
+    // 形状（隐藏类）：描述表的成员名到槽位的映射。成员名集合与加入顺序相同的表共享同一个形状，
+    // 形状创建后不再改变且永不释放，加入成员时沿转移边得到新的形状，可以安全地跨线程共享
+    class TableShape {
+      public:
+        static constexpr size_t npos = static_cast<size_t>(-1);
+
+        // 没有任何成员的根形状
+        static const TableShape *empty();
+
+        // 进程内唯一的编号（从1开始，0留给“尚未缓存”）
+        uint32_t id() const {
+            return shapeId;
+        }
+
+        // 成员个数
+        size_t size() const {
+            return names.size();
+        }
+
+        // 槽位上的成员名
+        const std::string &name(size_t slot) const {
+            return names[slot].str();
+        }
+
+        // 按成员名排序的槽位（遍历成员时使用，顺序与原先的有序映射一致）
+        const std::vector<size_t> &order() const {
+            return sorted;
+        }
+
+        // 成员所在槽位，不存在时返回npos（驻留的名字只比较地址）
+        size_t find(const std::string &name) const;
+        size_t find(Symbol name) const;
+
+        // 加入成员后的形状（已存在时返回自身），新成员占用末尾的槽位
+        const TableShape *add(const std::string &name) const;
+        const TableShape *add(Symbol name) const;
+
+        // 删除槽位上的成员后的形状，其余成员保持原有的先后顺序
+        const TableShape *remove(size_t slot) const;
+
+        // 记录类型（record Name { ... }）的形状：字段按声明顺序占用槽位，之后不能再增删成员；
+        // 类型名与字段列表相同的声明（例如反复解析同一脚本）得到同一个形状
+        static const TableShape *record(std::string name, const std::vector<std::string> &fields);
+
+        // 记录类型名（普通表的形状为空）
+        const std::string &record_name() const {
+            return recordName;
+        }
+
+        // 是否为记录类型的固定布局
+        bool sealed() const {
+            return !recordName.empty();
+        }
+
+      private:
+        TableShape();
+        TableShape(const TableShape &parent, Symbol name);
+
+        uint32_t shapeId;
+        std::string recordName;
+        std::vector<Symbol> names;  // 按槽位排列的成员名
+        std::vector<size_t> sorted; // 按成员名排序的槽位
+
+        mutable std::mutex mutex; // 保护转移表
+        mutable std::unordered_map<Symbol, std::unique_ptr<TableShape>, Symbol::Hash> transitions;
+    };
+
+    // 持久化有序映射（AVL树）：节点创建后不再改变并在副本之间共享，拷贝只复制根指针；
+    // 插入与删除只复制从根到目标的路径（O(log n)），原映射保持不变。节点按引用计数释放，可以跨线程共享
+    class PersistentMap {
+      public:
+        struct Node;
+
+        size_t size() const {
+            return count;
+        }
+
+        // 查找键，不存在时返回空
+        const ValueData *find(const ValueData &key) const;
+
+        // 插入或替换后的映射
+        PersistentMap set(const ValueData &key, ValueData value) const;
+
+        // 删除键后的映射（键不存在时返回自身的副本）
+        PersistentMap erase(const ValueData &key) const;
+
+        // 按键的顺序遍历：f(key, value)
+        void for_each(const std::function<void(const ValueData &, const ValueData &)> &f) const;
+
+      private:
+        std::shared_ptr<const Node> root;
+        size_t count = 0;
+    };
 
     // 表数据存储结构
     struct TableData {
         using ArrayMap = std::map<ValueData, ValueData>;
         ArrayMap array_map;
 
-        using DotMap = std::map<std::string, ValueData>;
-        DotMap dot_map;
+        // 成员部分：形状给出成员名到槽位的映射，成员值按槽位紧凑存放
+        const TableShape *shape = TableShape::empty();
+        std::vector<ValueData> slots;
+
+        // 冻结的表（table.freeze、const）：数组部分换成持久化映射，成员值整体共享，拷贝只复制指针。
+        // 原地写入前先解冻为普通表示（每个副本至多一次），不需要写入的副本始终不拷贝内容
+        PersistentMap frozen_array;
+        std::shared_ptr<const std::vector<ValueData>> frozen_slots;
+
+        // 是否为冻结表示
+        bool frozen() const {
+            return frozen_slots != nullptr;
+        }
+
+        // 成员值（按槽位，只读）
+        const std::vector<ValueData> &members() const {
+            return frozen_slots ? *frozen_slots : slots;
+        }
+
+        // 转为冻结表示（嵌套的表一并冻结）
+        void freeze();
+
+        // 解冻为可以原地修改的普通表示
+        void thaw();
+
+        // 数组部分的键值对个数
+        size_t array_size() const {
+            return frozen_slots ? frozen_array.size() : array_map.size();
+        }
+
+        // 查找数组部分的键，不存在时返回空
+        const ValueData *find_index(const ValueData &index) const;
+
+        // 按键的顺序遍历数组部分：f(key, value)
+        void for_each_index(const std::function<void(const ValueData &, const ValueData &)> &f) const;
+
+        // 更新一个键后的冻结表（原表不变）：已有同名成员时更新成员，否则更新数组部分（O(log n)）
+        TableData with(const ValueData &index, ValueData value) const;
+
+        // 删除一个键后的冻结表（原表不变）
+        TableData without(const ValueData &index) const;
+
+        // 查找成员，不存在时返回空
+        ValueData *find_member(const std::string &name);
+        const ValueData *find_member(const std::string &name) const;
+
+        // 成员不存在时加入，返回是否加入（已存在的成员保持不变）
+        bool emplace_dot(const std::string &name, ValueData value);
+
+        // 删除成员，返回是否存在
+        bool erase_dot(const std::string &name);
+
+        // 成员个数
+        size_t dot_size() const {
+            return members().size();
+        }
+
+        // 按成员名顺序遍历成员：f(name, value)
+        template <typename F> void for_each_dot(F &&f) const {
+            const std::vector<ValueData> &values = members();
+            for (size_t slot : shape->order())
+                f(shape->name(slot), values[slot]);
+        }
 
         ValueData &index_at(const ValueData &index);
+        const ValueData &index_at(const ValueData &index) const;
 
         ValueData &index(const ValueData &index);
 
         ValueData &dot_at(const std::string &name);
+        const ValueData &dot_at(const std::string &name) const;
 
         ValueData &dot(const std::string &name);
+        ValueData &dot(Symbol name);
+
+        // 删除数组部分的键，返回是否存在
+        bool erase(const ValueData &index);
 
         size_t length() const;
     };
@@ -54,16 +225,65 @@ namespace squ {
                      double,                                                 // 实数
                      bool,                                                   // 布尔
                      char,                                                   // 字符
-                     std::string,                                            // 字符串
+                     StringData,                                             // 字符串（共享内容，见 StringData）
                      std::vector<ValueData>,                                 // 数组
                      TableData,                                              // 表
-                     std::function<ValueData(std::vector<ValueData>&, VM &)>> // 函数
+                     std::function<ValueData(std::vector<ValueData>&, VM &)>, // 函数
+                     std::shared_ptr<ObjectData>>                            // 对象（按引用共享）
             value = 0.0;                                                     // 映射（使用字符串作为键）
 
         // 成员函数声明
         std::string string() const;
 
+        // 显式声明移动操作：用户声明的析构函数会抑制隐式移动，std::move 将退化为拷贝
+        ValueData() = default;
+        ValueData(const ValueData &) = default;
+        ValueData(ValueData &&) noexcept = default;
+        ValueData &operator=(const ValueData &) = default;
+        ValueData &operator=(ValueData &&) noexcept = default;
         ~ValueData() = default;
     };
 
+    // 对象数据基类：宿主扩展类型通过继承接入值系统
+    struct ObjectData : std::enable_shared_from_this<ObjectData> {
+        virtual ~ObjectData() = default;
+
+        // 类型名（用于@type）
+        virtual std::string type_name() const = 0;
+
+        // 字符串表示
+        virtual std::string string() const {
+            return "[" + type_name() + "]";
+        }
+
+        // 成员访问（obj.name），默认没有任何成员
+        virtual ValueData member(const std::string &name);
+
+        // 按整数下标读写元素（obj[i]、obj[i] = v）：支持的对象读出或写入后返回true，下标越界时抛出异常
+        virtual bool element(long long, ValueData &) const {
+            return false;
+        }
+        virtual bool set_element(long long, const ValueData &) {
+            return false;
+        }
+
+        // 只读字节视图：可以当作字符串使用的对象返回true并给出内容（不拷贝）
+        virtual bool bytes(std::string_view &) const {
+            return false;
+        }
+    };
+
+    // 字符串或可以当作字符串使用的对象（字节视图等）的内容，其他值返回false。
+    // 相等比较、表键与switch都按这里取得的内容处理，字节视图与内容相同的字符串视为相等
+    inline bool AsBytes(const ValueData &value, std::string_view &out) {
+        if (value.type == ValueType::String) {
+            out = std::get<StringData>(value.value).view();
+            return true;
+        }
+        return value.type == ValueType::Object && std::get<std::shared_ptr<ObjectData>>(value.value)->bytes(out);
+    }
+
+    // 存入表的键：字节视图等转为内容相同的字符串（不让键引用视图的所有者），其他值原样返回
+    ValueData TableKey(const ValueData &key);
+
 } // namespace squ
\ No newline at end of file
@@ -1,23 +1,69 @@
 #pragma once
+#include "output.h"
 #include "type.h"
 #include <cstddef>
+#include <memory>
 #include <vector>
 
 namespace squ {
 
+    // 协程恢复状态：生成器挂起时，沿途的语法节点由内向外记录各自的恢复位置；
+    // 恢复时从函数体根部重新进入，各节点由外向内取回位置并直接跳到挂起点
+    struct Coroutine {
+        std::vector<size_t> path; // 恢复位置（栈顶为最外层节点）
+        bool resuming = false;    // 是否正在沿记录的路径恢复
+        ValueData sent;           // 恢复时作为yield表达式的值
+
+        // 取出当前节点的恢复位置
+        size_t resume_point() {
+            size_t point = path.back();
+            path.pop_back();
+            return point;
+        }
+    };
+
     // 帧结构体，包含函数调用的相关信息
     struct Frame {
         size_t base;    // 该帧在 mem 里的起始下标
         size_t retAddr; // 字节码返回地址（先留空）
+        size_t size = 0; // 该帧的局部变量数量
+        Coroutine *coroutine = nullptr; // 生成器帧的恢复状态（普通帧为空）
         Frame() = default;
-        Frame(size_t b, size_t r) : base(b), retAddr(r) {}
+        Frame(size_t b, size_t r, size_t s = 0) : base(b), retAddr(r), size(s) {}
+    };
+
+    // 分段栈：按固定大小的段分配槽位，扩容时已有槽位的地址保持不变
+    // （函数调用期间持有的局部变量引用不会因为进入新帧而失效）
+    class SegmentedStack {
+      public:
+        static constexpr size_t kSegmentBits = 8;
+        static constexpr size_t kSegmentSize = static_cast<size_t>(1) << kSegmentBits;
+
+        ValueData &operator[](size_t i) {
+            return segments[i >> kSegmentBits][i & (kSegmentSize - 1)];
+        }
+        const ValueData &operator[](size_t i) const {
+            return segments[i >> kSegmentBits][i & (kSegmentSize - 1)];
+        }
+
+        size_t size() const {
+            return count;
+        }
+
+        // 调整大小：扩容按需分配新段，缩容时把释放的槽位重置为Nil
+        void resize(size_t n);
+
+      private:
+        std::vector<std::unique_ptr<ValueData[]>> segments;
+        size_t count = 0;
     };
 
     // 虚拟机类，管理内存和调用栈
     class VM {
       public:
-        std::vector<ValueData> mem;   // 一条胖数组
+        SegmentedStack mem;           // 分段的局部变量栈
         std::vector<Frame> callStack; // 调用栈
+        OutputBuffer out;             // @print 的输出缓冲区
 
         // 进入函数
         void enter(size_t localsNeeded);
@@ -28,6 +74,11 @@ namespace squ {
         // 读写局部变量
         ValueData &local(size_t slot);
 
+        // 当前帧的协程状态（不在生成器帧中时为空）
+        Coroutine *coroutine() const {
+            return callStack.empty() ? nullptr : callStack.back().coroutine;
+        }
+
         // 打印当前调用栈
         void printStack() const;
     };
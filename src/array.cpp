@@ -0,0 +1,555 @@
+#include "../include/array.h"
+#include "../include/identifier.h"
+#include <algorithm>
+#include <cstdlib>
+#include <stdexcept>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define SQU_SIMD_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#define SQU_TARGET_AVX2
+#else
+#define SQU_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#endif
+
+namespace squ {
+
+    using internal::TypeConverter;
+
+    namespace {
+
+        // 操作数形状：两侧逐元素，或一侧为标量（广播）
+        enum class Shape { VV, VS, SV };
+
+        //--------------------------------------------------
+        // 运算定义：scalar 为标量实现，sse2/avx2 为向量实现
+        // 比较运算的向量实现返回掩码（double）或已转成0/1的结果（整数）
+        //--------------------------------------------------
+        struct Add {
+            static constexpr bool vector_i64 = true;
+            template <typename T> static T scalar(T a, T b) {
+                return a + b;
+            }
+#ifdef SQU_SIMD_X86
+            static __m128d sse2(__m128d a, __m128d b) {
+                return _mm_add_pd(a, b);
+            }
+            SQU_TARGET_AVX2 static __m256d avx2(__m256d a, __m256d b) {
+                return _mm256_add_pd(a, b);
+            }
+            SQU_TARGET_AVX2 static __m256i avx2(__m256i a, __m256i b) {
+                return _mm256_add_epi64(a, b);
+            }
+#endif
+        };
+
+        struct Sub {
+            static constexpr bool vector_i64 = true;
+            template <typename T> static T scalar(T a, T b) {
+                return a - b;
+            }
+#ifdef SQU_SIMD_X86
+            static __m128d sse2(__m128d a, __m128d b) {
+                return _mm_sub_pd(a, b);
+            }
+            SQU_TARGET_AVX2 static __m256d avx2(__m256d a, __m256d b) {
+                return _mm256_sub_pd(a, b);
+            }
+            SQU_TARGET_AVX2 static __m256i avx2(__m256i a, __m256i b) {
+                return _mm256_sub_epi64(a, b);
+            }
+#endif
+        };
+
+        // 64位整数乘法没有AVX2指令，整数部分走标量循环
+        struct Mul {
+            static constexpr bool vector_i64 = false;
+            template <typename T> static T scalar(T a, T b) {
+                return a * b;
+            }
+#ifdef SQU_SIMD_X86
+            static __m128d sse2(__m128d a, __m128d b) {
+                return _mm_mul_pd(a, b);
+            }
+            SQU_TARGET_AVX2 static __m256d avx2(__m256d a, __m256d b) {
+                return _mm256_mul_pd(a, b);
+            }
+#endif
+        };
+
+        // 除法结果总是实数（与标量的 / 一致），按IEEE规则处理除零
+        struct Div {
+            static constexpr bool vector_i64 = false;
+            template <typename T> static T scalar(T a, T b) {
+                return a / b;
+            }
+#ifdef SQU_SIMD_X86
+            static __m128d sse2(__m128d a, __m128d b) {
+                return _mm_div_pd(a, b);
+            }
+            SQU_TARGET_AVX2 static __m256d avx2(__m256d a, __m256d b) {
+                return _mm256_div_pd(a, b);
+            }
+#endif
+        };
+
+#ifdef SQU_SIMD_X86
+        // 整数比较：AVX2 只有相等和大于，其余由交换操作数或取反得到
+        SQU_TARGET_AVX2 inline __m256i mask_to_bits(__m256i mask, bool invert) {
+            const __m256i one = _mm256_set1_epi64x(1);
+            return invert ? _mm256_andnot_si256(mask, one) : _mm256_and_si256(mask, one);
+        }
+#define SQU_COMPARE_VECTORS(SSE2, AVX2_PREDICATE, I64_MASK, INVERT)                                                  \
+    static __m128d sse2(__m128d a, __m128d b) {                                                                    \
+        return SSE2(a, b);                                                                                         \
+    }                                                                                                              \
+    SQU_TARGET_AVX2 static __m256d avx2(__m256d a, __m256d b) {                                                    \
+        return _mm256_cmp_pd(a, b, AVX2_PREDICATE);                                                                \
+    }                                                                                                              \
+    SQU_TARGET_AVX2 static __m256i avx2(__m256i a, __m256i b) {                                                    \
+        return mask_to_bits(I64_MASK, INVERT);                                                                     \
+    }
+#else
+#define SQU_COMPARE_VECTORS(SSE2, AVX2_PREDICATE, I64_MASK, INVERT)
+#endif
+
+#define SQU_COMPARE_OP(NAME, EXPR, SSE2, AVX2_PREDICATE, I64_MASK, INVERT)                                           \
+    struct NAME {                                                                                                  \
+        static constexpr bool vector_i64 = true;                                                                   \
+        template <typename T> static long long scalar(T a, T b) {                                                  \
+            return (EXPR) ? 1 : 0;                                                                                 \
+        }                                                                                                          \
+        SQU_COMPARE_VECTORS(SSE2, AVX2_PREDICATE, I64_MASK, INVERT)                                                \
+    };
+
+        SQU_COMPARE_OP(Eq, a == b, _mm_cmpeq_pd, _CMP_EQ_OQ, _mm256_cmpeq_epi64(a, b), false)
+        SQU_COMPARE_OP(Ne, a != b, _mm_cmpneq_pd, _CMP_NEQ_UQ, _mm256_cmpeq_epi64(a, b), true)
+        SQU_COMPARE_OP(Lt, a < b, _mm_cmplt_pd, _CMP_LT_OQ, _mm256_cmpgt_epi64(b, a), false)
+        SQU_COMPARE_OP(Le, a <= b, _mm_cmple_pd, _CMP_LE_OQ, _mm256_cmpgt_epi64(a, b), true)
+        SQU_COMPARE_OP(Gt, a > b, _mm_cmpgt_pd, _CMP_GT_OQ, _mm256_cmpgt_epi64(a, b), false)
+        SQU_COMPARE_OP(Ge, a >= b, _mm_cmpge_pd, _CMP_GE_OQ, _mm256_cmpgt_epi64(b, a), true)
+
+#undef SQU_COMPARE_OP
+#undef SQU_COMPARE_VECTORS
+
+        //--------------------------------------------------
+        // 内核：标量循环处理尾部及不支持SIMD的平台
+        //--------------------------------------------------
+        template <typename Op, typename In, typename Out>
+        void scalar_kernel(const In *a, const In *b, Out *out, size_t n, Shape shape, size_t i = 0) {
+            switch (shape) {
+            case Shape::VV:
+                for (; i < n; ++i)
+                    out[i] = Op::scalar(a[i], b[i]);
+                break;
+            case Shape::VS: {
+                In y = b[0];
+                for (; i < n; ++i)
+                    out[i] = Op::scalar(a[i], y);
+                break;
+            }
+            case Shape::SV: {
+                In x = a[0];
+                for (; i < n; ++i)
+                    out[i] = Op::scalar(x, b[i]);
+                break;
+            }
+            }
+        }
+
+#ifdef SQU_SIMD_X86
+        // 写出结果：算术结果原样写出，比较掩码转成0/1整数
+        inline void store_sse2(double *p, __m128d v) {
+            _mm_storeu_pd(p, v);
+        }
+        inline void store_sse2(long long *p, __m128d mask) {
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(p),
+                             _mm_and_si128(_mm_castpd_si128(mask), _mm_set1_epi64x(1)));
+        }
+        SQU_TARGET_AVX2 inline void store_avx2(double *p, __m256d v) {
+            _mm256_storeu_pd(p, v);
+        }
+        SQU_TARGET_AVX2 inline void store_avx2(long long *p, __m256d mask) {
+            _mm256_storeu_si256(reinterpret_cast<__m256i *>(p),
+                                _mm256_and_si256(_mm256_castpd_si256(mask), _mm256_set1_epi64x(1)));
+        }
+
+        // 双精度：SSE2（x86-64基线），每次2个元素
+        template <typename Op, typename Out>
+        void f64_sse2(const double *a, const double *b, Out *out, size_t n, Shape shape) {
+            const __m128d x0 = _mm_set1_pd(shape == Shape::SV ? a[0] : 0.0);
+            const __m128d y0 = _mm_set1_pd(shape == Shape::VS ? b[0] : 0.0);
+            size_t i = 0;
+            for (; i + 2 <= n; i += 2) {
+                __m128d x = shape == Shape::SV ? x0 : _mm_loadu_pd(a + i);
+                __m128d y = shape == Shape::VS ? y0 : _mm_loadu_pd(b + i);
+                store_sse2(out + i, Op::sse2(x, y));
+            }
+            scalar_kernel<Op>(a, b, out, n, shape, i);
+        }
+
+        // 双精度：AVX2，每次4个元素
+        template <typename Op, typename Out>
+        SQU_TARGET_AVX2 void f64_avx2(const double *a, const double *b, Out *out, size_t n, Shape shape) {
+            const __m256d x0 = _mm256_set1_pd(shape == Shape::SV ? a[0] : 0.0);
+            const __m256d y0 = _mm256_set1_pd(shape == Shape::VS ? b[0] : 0.0);
+            size_t i = 0;
+            for (; i + 4 <= n; i += 4) {
+                __m256d x = shape == Shape::SV ? x0 : _mm256_loadu_pd(a + i);
+                __m256d y = shape == Shape::VS ? y0 : _mm256_loadu_pd(b + i);
+                store_avx2(out + i, Op::avx2(x, y));
+            }
+            scalar_kernel<Op>(a, b, out, n, shape, i);
+        }
+
+        // 64位整数：AVX2，每次4个元素
+        template <typename Op>
+        SQU_TARGET_AVX2 void i64_avx2(const long long *a, const long long *b, long long *out, size_t n, Shape shape) {
+            const __m256i x0 = _mm256_set1_epi64x(shape == Shape::SV ? a[0] : 0);
+            const __m256i y0 = _mm256_set1_epi64x(shape == Shape::VS ? b[0] : 0);
+            size_t i = 0;
+            for (; i + 4 <= n; i += 4) {
+                __m256i x = shape == Shape::SV ? x0 : _mm256_loadu_si256(reinterpret_cast<const __m256i *>(a + i));
+                __m256i y = shape == Shape::VS ? y0 : _mm256_loadu_si256(reinterpret_cast<const __m256i *>(b + i));
+                _mm256_storeu_si256(reinterpret_cast<__m256i *>(out + i), Op::avx2(x, y));
+            }
+            scalar_kernel<Op>(a, b, out, n, shape, i);
+        }
+
+        // 运行时检测AVX2（结果缓存）
+        bool detect_avx2() {
+#if defined(_MSC_VER) && !defined(__clang__)
+            int info[4];
+            __cpuid(info, 0);
+            if (info[0] < 7)
+                return false;
+            __cpuid(info, 1);
+            bool osxsave = (info[2] & (1 << 27)) != 0;
+            bool avx = (info[2] & (1 << 28)) != 0;
+            if (!osxsave || !avx || (_xgetbv(0) & 0x6) != 0x6)
+                return false; // 操作系统未保存YMM寄存器
+            __cpuidex(info, 7, 0);
+            return (info[1] & (1 << 5)) != 0;
+#else
+            __builtin_cpu_init();
+            return __builtin_cpu_supports("avx2") != 0;
+#endif
+        }
+
+        // 环境变量 SQUAKER_SIMD=sse2 时只用SSE2（测试两条路径的结果一致）
+        bool has_avx2() {
+            static const bool supported = [] {
+                const char *simd = std::getenv("SQUAKER_SIMD");
+                return !(simd && std::string(simd) == "sse2") && detect_avx2();
+            }();
+            return supported;
+        }
+#endif
+
+        // 双精度分派
+        template <typename Op, typename Out>
+        void run_f64(const double *a, const double *b, Out *out, size_t n, Shape shape) {
+#ifdef SQU_SIMD_X86
+            if (has_avx2()) {
+                f64_avx2<Op>(a, b, out, n, shape);
+            } else {
+                f64_sse2<Op>(a, b, out, n, shape);
+            }
+#else
+            scalar_kernel<Op>(a, b, out, n, shape);
+#endif
+        }
+
+        // 整数分派
+        template <typename Op>
+        void run_i64(const long long *a, const long long *b, long long *out, size_t n, Shape shape) {
+#ifdef SQU_SIMD_X86
+            if constexpr (Op::vector_i64) {
+                if (has_avx2()) {
+                    i64_avx2<Op>(a, b, out, n, shape);
+                    return;
+                }
+            }
+#endif
+            scalar_kernel<Op>(a, b, out, n, shape);
+        }
+
+        //--------------------------------------------------
+        // 操作数
+        //--------------------------------------------------
+        struct Operand {
+            bool array = false;                // 是否为类型化数组
+            bool real = false;                 // 元素是否为实数
+            size_t size = 1;                   // 元素数量（标量为1）
+            const double *reals = nullptr;     // 实数元素
+            const long long *integers = nullptr; // 整数元素
+            double realValue = 0.0;            // 实数标量
+            long long integerValue = 0;        // 整数标量
+            std::vector<double> widened;       // 整数转实数时的临时存储
+        };
+
+        // 解析操作数：类型化数组、整数或实数
+        bool resolve(const ValueData &value, Operand &out) {
+            switch (value.type) {
+            case ValueType::Integer:
+                out.integerValue = std::get<long long>(value.value);
+                out.integers = &out.integerValue;
+                return true;
+            case ValueType::Real:
+                out.real = true;
+                out.realValue = std::get<double>(value.value);
+                out.reals = &out.realValue;
+                return true;
+            case ValueType::Object: {
+                ObjectData *object = std::get<std::shared_ptr<ObjectData>>(value.value).get();
+                if (auto *f = dynamic_cast<Float64Array *>(object)) {
+                    out.array = out.real = true;
+                    out.size = f->data.size();
+                    out.reals = f->data.data();
+                    return true;
+                }
+                if (auto *i = dynamic_cast<Int64Array *>(object)) {
+                    out.array = true;
+                    out.size = i->data.size();
+                    out.integers = i->data.data();
+                    return true;
+                }
+                return false;
+            }
+            default:
+                return false;
+            }
+        }
+
+        // 取实数元素（整数操作数转换一次）
+        const double *as_reals(Operand &operand) {
+            if (operand.real)
+                return operand.reals;
+            operand.widened.assign(operand.integers, operand.integers + operand.size);
+            return operand.widened.data();
+        }
+
+        // 计算结果：比较运算得到0/1整数数组
+        template <typename Op, bool Compare>
+        ValueData compute(Operand &lhs, Operand &rhs, bool real, size_t n, Shape shape) {
+            if (real) {
+                const double *a = as_reals(lhs);
+                const double *b = as_reals(rhs);
+                if constexpr (Compare) {
+                    std::vector<long long> out(n);
+                    run_f64<Op>(a, b, out.data(), n, shape);
+                    return MakeTypedArray(std::move(out));
+                } else {
+                    std::vector<double> out(n);
+                    run_f64<Op>(a, b, out.data(), n, shape);
+                    return MakeTypedArray(std::move(out));
+                }
+            }
+            std::vector<long long> out(n);
+            run_i64<Op>(lhs.integers, rhs.integers, out.data(), n, shape);
+            return MakeTypedArray(std::move(out));
+        }
+
+        // 按元素类型转换
+        template <typename T, typename U> std::vector<T> convert_elements(const std::vector<U> &source) {
+            if constexpr (std::is_same_v<T, U>) {
+                return source;
+            } else {
+                return std::vector<T>(source.begin(), source.end());
+            }
+        }
+
+    } // namespace
+
+    //--------------------------------------------------
+    // 类型化数组
+    //--------------------------------------------------
+    template <> std::string TypedArray<double>::type_name() const {
+        return "float64array";
+    }
+
+    template <> std::string TypedArray<long long>::type_name() const {
+        return "int64array";
+    }
+
+    // 字符串表示（元素格式与普通数组一致）
+    template <typename T> std::string TypedArray<T>::string() const {
+        std::string result = type_name() + "[";
+        for (size_t i = 0; i < data.size(); i++) {
+            if (i > 0)
+                result += ", ";
+            result += std::to_string(data[i]);
+        }
+        return result + "]";
+    }
+
+    // 下标检查
+    static size_t CheckIndex(size_t size, long long i) {
+        if (i < 0 || static_cast<size_t>(i) >= size) {
+            throw std::out_of_range("[squaker.array] Index out of range: " + std::to_string(i));
+        }
+        return static_cast<size_t>(i);
+    }
+
+    // 按下标读取元素
+    template <typename T> bool TypedArray<T>::element(long long index, ValueData &out) const {
+        out = TypeConverter<T>::convert_to_value(data[CheckIndex(data.size(), index)]);
+        return true;
+    }
+
+    // 按下标写入元素（实数数组也接受整数）
+    template <typename T> bool TypedArray<T>::set_element(long long index, const ValueData &value) {
+        data[CheckIndex(data.size(), index)] = static_cast<T>(TypeConverter<T>::convert(value));
+        return true;
+    }
+
+    // 成员
+    template <typename T> ValueData TypedArray<T>::member(const std::string &name) {
+        auto self = std::static_pointer_cast<TypedArray<T>>(shared_from_this());
+        auto check = [](const TypedArray<T> &array, long long i) { return CheckIndex(array.data.size(), i); };
+        if (name == "length") {
+            return make_function([self]() { return static_cast<long long>(self->data.size()); });
+        }
+        if (name == "get") {
+            return make_function([self, check](long long i) { return self->data[check(*self, i)]; });
+        }
+        if (name == "set") {
+            return make_function([self, check](long long i, ValueData value) {
+                self->data[check(*self, i)] = static_cast<T>(TypeConverter<T>::convert(value));
+            });
+        }
+        if (name == "push") {
+            return make_function(
+                [self](ValueData value) { self->data.push_back(static_cast<T>(TypeConverter<T>::convert(value))); });
+        }
+        if (name == "sum") {
+            return make_function([self]() {
+                T total = 0;
+                for (T x : self->data)
+                    total += x;
+                return total;
+            });
+        }
+        if (name == "min" || name == "max") {
+            bool isMin = name == "min";
+            return make_function([self, isMin]() {
+                if (self->data.empty()) {
+                    throw std::runtime_error("[squaker.array] min/max of an empty array");
+                }
+                auto it = isMin ? std::min_element(self->data.begin(), self->data.end())
+                                : std::max_element(self->data.begin(), self->data.end());
+                return *it;
+            });
+        }
+        if (name == "slice") {
+            return make_function([self](long long start, long long end) {
+                if (start < 0 || start > end || static_cast<size_t>(end) > self->data.size()) {
+                    throw std::out_of_range("[squaker.array] Slice out of range: [" + std::to_string(start) + ", " +
+                                            std::to_string(end) + ") of " + std::to_string(self->data.size()));
+                }
+                return MakeTypedArray(std::vector<T>(self->data.begin() + start, self->data.begin() + end));
+            });
+        }
+        if (name == "array") {
+            return make_function([self]() {
+                std::vector<ValueData> result;
+                result.reserve(self->data.size());
+                for (T x : self->data)
+                    result.push_back(TypeConverter<T>::convert_to_value(x));
+                return ValueData{ValueType::Array, false, std::move(result)};
+            });
+        }
+        return ObjectData::member(name);
+    }
+
+    template class TypedArray<double>;
+    template class TypedArray<long long>;
+
+    // 从脚本值取出元素
+    template <typename T> std::vector<T> ToTypedVector(const ValueData &source) {
+        switch (source.type) {
+        case ValueType::Object: {
+            ObjectData *object = std::get<std::shared_ptr<ObjectData>>(source.value).get();
+            if (auto *f = dynamic_cast<Float64Array *>(object))
+                return convert_elements<T>(f->data);
+            if (auto *i = dynamic_cast<Int64Array *>(object))
+                return convert_elements<T>(i->data);
+            break;
+        }
+        case ValueType::Array: {
+            const auto &elements = std::get<std::vector<ValueData>>(source.value);
+            std::vector<T> result;
+            result.reserve(elements.size());
+            for (const auto &element : elements)
+                result.push_back(static_cast<T>(TypeConverter<T>::convert(element)));
+            return result;
+        }
+        case ValueType::Table: {
+            const auto &table = std::get<TableData>(source.value);
+            std::vector<T> result;
+            result.reserve(table.array_size());
+            table.for_each_index([&result](const ValueData &, const ValueData &value) {
+                result.push_back(static_cast<T>(TypeConverter<T>::convert(value)));
+            });
+            return result;
+        }
+        default:
+            break;
+        }
+        throw std::runtime_error("[squaker.array] Expected a typed array, array or table");
+    }
+
+    template std::vector<double> ToTypedVector<double>(const ValueData &source);
+    template std::vector<long long> ToTypedVector<long long>(const ValueData &source);
+
+    // 逐元素二元运算
+    bool ApplyArrayBinary(const ValueData &lhs, const std::string &op, const ValueData &rhs, ValueData &result) {
+        Operand l, r;
+        bool lhsNumeric = resolve(lhs, l);
+        bool rhsNumeric = resolve(rhs, r);
+        if (!l.array && !r.array) {
+            return false;
+        }
+        if (!lhsNumeric || !rhsNumeric) {
+            // 与非数值比较时按对象身份处理
+            if (op == "==" || op == "!=")
+                return false;
+            throw std::runtime_error("[squaker.array] unsupported operand types for operator " + op);
+        }
+        if (l.array && r.array && l.size != r.size) {
+            throw std::runtime_error("[squaker.array] Length mismatch for operator " + op + ": " +
+                                     std::to_string(l.size) + " vs " + std::to_string(r.size));
+        }
+        Shape shape = l.array && r.array ? Shape::VV : l.array ? Shape::VS : Shape::SV;
+        size_t n = l.array ? l.size : r.size;
+        bool real = l.real || r.real;
+
+        if (op == "+")
+            result = compute<Add, false>(l, r, real, n, shape);
+        else if (op == "-")
+            result = compute<Sub, false>(l, r, real, n, shape);
+        else if (op == "*")
+            result = compute<Mul, false>(l, r, real, n, shape);
+        else if (op == "/")
+            result = compute<Div, false>(l, r, true, n, shape);
+        else if (op == "==")
+            result = compute<Eq, true>(l, r, real, n, shape);
+        else if (op == "!=")
+            result = compute<Ne, true>(l, r, real, n, shape);
+        else if (op == "<")
+            result = compute<Lt, true>(l, r, real, n, shape);
+        else if (op == "<=")
+            result = compute<Le, true>(l, r, real, n, shape);
+        else if (op == ">")
+            result = compute<Gt, true>(l, r, real, n, shape);
+        else if (op == ">=")
+            result = compute<Ge, true>(l, r, real, n, shape);
+        else
+            return false; // 其他运算符（如 ..）按普通规则处理
+        return true;
+    }
+
+} // namespace squ
\ No newline at end of file
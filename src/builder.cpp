@@ -0,0 +1,39 @@
+#include "../include/builder.h"
+#include "../include/identifier.h"
+#include "../include/operator.h"
+#include <stdexcept>
+
+namespace squ {
+
+    // 构建器成员
+    ValueData StringBuilder::member(const std::string &name) {
+        auto self = std::static_pointer_cast<StringBuilder>(shared_from_this());
+        if (name == "append") {
+            // 追加任意个值（规则与 .. 相同），返回构建器本身以便连续调用
+            return ValueData{ValueType::Function, false, [self](std::vector<ValueData> &args, VM &) -> ValueData {
+                                 for (const auto &arg : args)
+                                     AppendConcat(self->text, arg);
+                                 return ValueData{ValueType::Object, false, std::shared_ptr<ObjectData>(self)};
+                             }};
+        }
+        if (name == "length") {
+            return make_function([self]() { return static_cast<long long>(self->text.size()); });
+        }
+        if (name == "reserve") {
+            return make_function([self](long long bytes) {
+                if (bytes < 0) {
+                    throw std::runtime_error("[squaker.builder] Capacity must not be negative");
+                }
+                self->text.reserve(static_cast<size_t>(bytes));
+            });
+        }
+        if (name == "clear") {
+            return make_function([self]() { self->text.clear(); });
+        }
+        if (name == "str") {
+            return make_function([self]() { return self->text; });
+        }
+        return ObjectData::member(name);
+    }
+
+} // namespace squ
\ No newline at end of file
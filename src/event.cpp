@@ -0,0 +1,546 @@
+#include "../include/event.h"
+#include "../include/generator.h"
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <stdexcept>
+#include <thread>
+
+#ifdef __linux__
+#include <fcntl.h>
+#include <spawn.h>
+#include <sys/epoll.h>
+#include <sys/wait.h>
+#include <unistd.h>
+extern char **environ;
+#endif
+
+namespace squ {
+
+    static constexpr size_t kChunkSize = 64 * 1024; // 每次读写的块大小
+
+    // 调用脚本回调
+    static ValueData invoke(const ValueData &callback, std::vector<ValueData> args, VM &vm) {
+        if (callback.type != ValueType::Function) {
+            throw std::runtime_error("[squaker.event] Callback is not a function: " + callback.string());
+        }
+        return std::get<std::function<ValueData(std::vector<ValueData> &, VM &)>>(callback.value)(args, vm);
+    }
+
+    // 字符串值
+    static ValueData text(std::string s) {
+        return ValueData{ValueType::String, false, std::move(s)};
+    }
+
+#ifdef __linux__
+    // 设置为非阻塞
+    static void set_nonblocking(int fd) {
+        int flags = fcntl(fd, F_GETFL, 0);
+        if (flags < 0 || fcntl(fd, F_SETFL, flags | O_NONBLOCK) < 0) {
+            throw std::runtime_error("[squaker.event] Invalid file descriptor: " + std::to_string(fd));
+        }
+    }
+#else
+    [[noreturn]] static void unsupported(const char *what) {
+        throw std::runtime_error(std::string("[squaker.event] ") + what + " is only supported on Linux");
+    }
+#endif
+
+    // 当前线程的事件循环
+    EventLoop &EventLoop::current() {
+        static thread_local EventLoop loop;
+        return loop;
+    }
+
+    EventLoop::EventLoop() {
+#ifdef __linux__
+        pollFd = epoll_create1(EPOLL_CLOEXEC);
+        if (pollFd < 0) {
+            throw std::runtime_error(std::string("[squaker.event] epoll_create1 failed: ") + std::strerror(errno));
+        }
+#endif
+    }
+
+    EventLoop::~EventLoop() {
+#ifdef __linux__
+        // 子进程管道由循环创建，一并关闭
+        for (auto &[fd, watch] : watches) {
+            if (watch.pid >= 0)
+                ::close(fd);
+        }
+        ::close(pollFd);
+#endif
+    }
+
+    // 单调时钟（毫秒）
+    long long EventLoop::now() {
+        using namespace std::chrono;
+        return duration_cast<milliseconds>(steady_clock::now().time_since_epoch()).count();
+    }
+
+    // 定时器
+    long long EventLoop::add_timer(long long delay, long long interval, ValueData callback) {
+        if (callback.type != ValueType::Function) {
+            throw std::runtime_error("[squaker.event] Timer callback is not a function: " + callback.string());
+        }
+        long long id = nextId++;
+        timers[id] = Timer{std::max(interval, 0LL), std::move(callback), false};
+        timerQueue.push(TimerEntry{now() + std::max(delay, 0LL), id});
+        return id;
+    }
+
+    // 协程
+    long long EventLoop::add_coroutine(ValueData generator) {
+        if (generator.type != ValueType::Object ||
+            !dynamic_cast<GeneratorData *>(std::get<std::shared_ptr<ObjectData>>(generator.value).get())) {
+            throw std::runtime_error("[squaker.event] go expects a generator: " + generator.string());
+        }
+        long long id = nextId++;
+        timers[id] = Timer{0, std::move(generator), true};
+        timerQueue.push(TimerEntry{now(), id});
+        return id;
+    }
+
+    // 取消定时器或协程（队列中的项在弹出时丢弃）
+    bool EventLoop::cancel(long long id) {
+        return timers.erase(id) > 0;
+    }
+
+    // 监听可读
+    void EventLoop::watch(int fd, ValueData callback) {
+#ifdef __linux__
+        if (callback.type != ValueType::Function) {
+            throw std::runtime_error("[squaker.event] Watch callback is not a function: " + callback.string());
+        }
+        set_nonblocking(fd);
+        watches[fd].onData = std::move(callback);
+        update_interest(fd);
+#else
+        unsupported("watch");
+#endif
+    }
+
+    // 非阻塞写
+    void EventLoop::write(int fd, std::string data) {
+#ifdef __linux__
+        auto it = watches.find(fd);
+        if (it == watches.end()) {
+            set_nonblocking(fd);
+            it = watches.emplace(fd, Watch{}).first;
+        }
+        if (it->second.closing) {
+            throw std::runtime_error("[squaker.event] Write after close on fd " + std::to_string(fd));
+        }
+        it->second.output += data;
+        flush(fd);
+#else
+        unsupported("write");
+#endif
+    }
+
+    // 关闭文件描述符
+    void EventLoop::close(int fd) {
+#ifdef __linux__
+        auto it = watches.find(fd);
+        if (it == watches.end()) {
+            ::close(fd);
+            return;
+        }
+        it->second.onData = ValueData{ValueType::Nil};
+        if (it->second.output.empty()) {
+            release(fd);
+        } else {
+            // 等缓存写完再关闭
+            it->second.closing = true;
+            update_interest(fd);
+        }
+#else
+        unsupported("close");
+#endif
+    }
+
+    // 创建非阻塞管道
+    std::pair<int, int> EventLoop::pipe() {
+#ifdef __linux__
+        int fds[2];
+        if (pipe2(fds, O_NONBLOCK | O_CLOEXEC) < 0) {
+            throw std::runtime_error(std::string("[squaker.event] pipe failed: ") + std::strerror(errno));
+        }
+        return {fds[0], fds[1]};
+#else
+        unsupported("pipe");
+#endif
+    }
+
+    // 启动子进程
+    long long EventLoop::popen(const std::string &command, ValueData onData, ValueData onExit) {
+#ifdef __linux__
+        int fds[2];
+        if (pipe2(fds, O_CLOEXEC) < 0) {
+            throw std::runtime_error(std::string("[squaker.event] pipe failed: ") + std::strerror(errno));
+        }
+        // 子进程的标准输出接到管道写端
+        posix_spawn_file_actions_t actions;
+        posix_spawn_file_actions_init(&actions);
+        posix_spawn_file_actions_adddup2(&actions, fds[1], STDOUT_FILENO);
+        const char *argv[] = {"sh", "-c", command.c_str(), nullptr};
+        pid_t pid;
+        int err = posix_spawn(&pid, "/bin/sh", &actions, nullptr, const_cast<char *const *>(argv), environ);
+        posix_spawn_file_actions_destroy(&actions);
+        ::close(fds[1]);
+        if (err != 0) {
+            ::close(fds[0]);
+            throw std::runtime_error("[squaker.event] Failed to start process: " + command + " (" +
+                                     std::strerror(err) + ")");
+        }
+
+        set_nonblocking(fds[0]);
+        Watch &watch = watches[fds[0]];
+        watch.onData = std::move(onData);
+        watch.onExit = std::move(onExit);
+        watch.pid = pid;
+        update_interest(fds[0]);
+        return pid;
+#else
+        unsupported("popen");
+#endif
+    }
+
+    // 分块读取文件
+    void EventLoop::read_file(const std::string &path, ValueData callback) {
+        std::FILE *file = std::fopen(path.c_str(), "rb");
+        if (!file) {
+            throw std::runtime_error("[squaker.event] Failed to open file: " + path);
+        }
+        FileJob job;
+        job.path = path;
+        job.file = std::shared_ptr<std::FILE>(file, std::fclose);
+        job.callback = std::move(callback);
+        fileJobs.push_back(std::move(job));
+    }
+
+    // 分块写入文件
+    void EventLoop::write_file(const std::string &path, std::string content, ValueData callback) {
+        std::FILE *file = std::fopen(path.c_str(), "wb");
+        if (!file) {
+            throw std::runtime_error("[squaker.event] Failed to open file for writing: " + path);
+        }
+        FileJob job;
+        job.path = path;
+        job.writing = true;
+        job.data = std::move(content);
+        job.file = std::shared_ptr<std::FILE>(file, std::fclose);
+        job.callback = std::move(callback);
+        fileJobs.push_back(std::move(job));
+    }
+
+    // 运行事件循环
+    void EventLoop::run(VM &vm) {
+        if (running) {
+            throw std::runtime_error("[squaker.event] Event loop is already running");
+        }
+        running = true;
+        stopping = false;
+        try {
+            while (!stopping && alive()) {
+                fire_timers(vm);
+                if (stopping)
+                    break;
+                step_file_jobs(vm);
+                reap_children(vm);
+                if (stopping || !alive())
+                    break;
+
+                // 计算等待时间：有文件任务时不等待，否则等到最近的定时器
+                long long timeout = -1;
+                if (!fileJobs.empty()) {
+                    timeout = 0;
+                } else if (!timerQueue.empty()) {
+                    timeout = std::max(0LL, timerQueue.top().when - now());
+                }
+                if (!children.empty()) {
+                    timeout = timeout < 0 ? 10 : std::min(timeout, 10LL); // 轮询子进程退出
+                }
+                poll(vm, timeout);
+            }
+        } catch (...) {
+            running = false;
+            throw;
+        }
+        running = false;
+    }
+
+    // 请求停止
+    void EventLoop::stop() {
+        stopping = true;
+    }
+
+    // 触发到期的定时器与协程
+    void EventLoop::fire_timers(VM &vm) {
+        // 先取出本轮到期的项，回调中新加的定时器留到下一轮，避免零延迟定时器饿死I/O
+        long long t = now();
+        std::vector<long long> due;
+        while (!timerQueue.empty() && timerQueue.top().when <= t) {
+            due.push_back(timerQueue.top().id);
+            timerQueue.pop();
+        }
+
+        for (long long id : due) {
+            if (stopping)
+                break;
+            auto it = timers.find(id);
+            if (it == timers.end())
+                continue; // 已取消
+
+            if (it->second.coroutine) {
+                // 恢复协程，产出值决定下次恢复的时间
+                ValueData handle = it->second.callback;
+                auto *generator =
+                    static_cast<GeneratorData *>(std::get<std::shared_ptr<ObjectData>>(handle.value).get());
+                if (generator->done(vm)) {
+                    timers.erase(id);
+                    continue;
+                }
+                ValueData delay = generator->next(vm, ValueData{ValueType::Nil});
+                if (timers.find(id) == timers.end())
+                    continue; // 协程在运行中取消了自己
+                long long ms = delay.type == ValueType::Integer ? std::max(0LL, std::get<long long>(delay.value)) : 0;
+                timerQueue.push(TimerEntry{now() + ms, id});
+            } else {
+                ValueData callback = it->second.callback;
+                if (it->second.interval > 0) {
+                    timerQueue.push(TimerEntry{t + it->second.interval, id});
+                } else {
+                    timers.erase(it);
+                }
+                invoke(callback, {}, vm);
+            }
+        }
+
+        // 没有定时器时清掉已取消的残留项
+        if (timers.empty()) {
+            timerQueue = decltype(timerQueue)();
+        }
+    }
+
+    // 推进文件任务，每个任务一块
+    void EventLoop::step_file_jobs(VM &vm) {
+        std::vector<FileJob> finished;
+        for (size_t i = 0; i < fileJobs.size();) {
+            FileJob &job = fileJobs[i];
+            bool done = false;
+            if (job.writing) {
+                size_t n = std::min(kChunkSize, job.data.size() - job.offset);
+                if (n > 0 && std::fwrite(job.data.data() + job.offset, 1, n, job.file.get()) != n) {
+                    throw std::runtime_error("[squaker.event] Failed to write file: " + job.path);
+                }
+                job.offset += n;
+                done = job.offset == job.data.size();
+            } else {
+                size_t old = job.data.size();
+                job.data.resize(old + kChunkSize);
+                size_t n = std::fread(&job.data[old], 1, kChunkSize, job.file.get());
+                job.data.resize(old + n);
+                if (n < kChunkSize) {
+                    if (std::ferror(job.file.get())) {
+                        throw std::runtime_error("[squaker.event] Failed to read file: " + job.path);
+                    }
+                    done = true;
+                }
+            }
+            if (done) {
+                finished.push_back(std::move(job));
+                fileJobs.erase(fileJobs.begin() + static_cast<std::ptrdiff_t>(i));
+            } else {
+                i++;
+            }
+        }
+
+        // 回调可能新增任务，放在遍历之后调用
+        for (auto &job : finished) {
+            job.file.reset(); // 先关闭文件，回调里可以立即读取写好的内容
+            if (job.callback.type == ValueType::Nil)
+                continue;
+            if (job.writing) {
+                invoke(job.callback, {}, vm);
+            } else {
+                invoke(job.callback, {text(std::move(job.data))}, vm);
+            }
+        }
+    }
+
+    // 回收已退出的子进程
+    void EventLoop::reap_children(VM &vm) {
+#ifdef __linux__
+        for (size_t i = 0; i < children.size();) {
+            int status = 0;
+            pid_t r = waitpid(static_cast<pid_t>(children[i].pid), &status, WNOHANG);
+            if (r == 0) {
+                i++;
+                continue;
+            }
+            ValueData onExit = std::move(children[i].onExit);
+            children.erase(children.begin() + static_cast<std::ptrdiff_t>(i));
+            long long code = (r > 0 && WIFEXITED(status)) ? WEXITSTATUS(status) : -1;
+            if (onExit.type != ValueType::Nil) {
+                invoke(onExit, {ValueData{ValueType::Integer, false, code}}, vm);
+            }
+        }
+#endif
+    }
+
+    // 等待并分发I/O事件
+    void EventLoop::poll(VM &vm, long long timeout) {
+#ifdef __linux__
+        epoll_event events[64];
+        int n = epoll_wait(pollFd, events, 64, static_cast<int>(std::min(timeout, 1LL << 30)));
+        if (n < 0) {
+            if (errno == EINTR)
+                return;
+            throw std::runtime_error(std::string("[squaker.event] epoll_wait failed: ") + std::strerror(errno));
+        }
+        for (int i = 0; i < n; i++) {
+            int fd = events[i].data.fd;
+            uint32_t ev = events[i].events;
+            auto it = watches.find(fd);
+            if (it == watches.end())
+                continue; // 前面的回调已经关闭了它
+
+            if (ev & EPOLLOUT) {
+                flush(fd);
+                it = watches.find(fd);
+                if (it == watches.end())
+                    continue;
+            }
+
+            bool reading = it->second.onData.type != ValueType::Nil || it->second.pid >= 0;
+            if (reading && (ev & (EPOLLIN | EPOLLHUP | EPOLLERR))) {
+                if (handle_readable(fd, vm)) {
+                    // 读到结尾：停止监听，子进程转入等待回收
+                    it = watches.find(fd);
+                    if (it == watches.end())
+                        continue;
+                    ValueData onData = std::move(it->second.onData);
+                    if (it->second.pid >= 0) {
+                        children.push_back(Child{it->second.pid, std::move(it->second.onExit)});
+                    }
+                    release(fd);
+                    if (onData.type != ValueType::Nil) {
+                        invoke(onData, {text("")}, vm);
+                    }
+                }
+            } else if (!reading && (ev & (EPOLLHUP | EPOLLERR))) {
+                // 写端对方已关闭，丢弃未写出的数据
+                release(fd);
+            }
+        }
+#else
+        if (timeout > 0) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(timeout));
+        }
+#endif
+    }
+
+    // 处理可读事件：每次就绪只读一块，水平触发会继续通知
+    bool EventLoop::handle_readable(int fd, VM &vm) {
+#ifdef __linux__
+        char buffer[kChunkSize];
+        while (true) {
+            ssize_t n = ::read(fd, buffer, sizeof(buffer));
+            if (n > 0) {
+                ValueData onData = watches[fd].onData;
+                if (onData.type != ValueType::Nil) {
+                    invoke(onData, {text(std::string(buffer, static_cast<size_t>(n)))}, vm);
+                }
+                return false;
+            }
+            if (n == 0)
+                return true;
+            if (errno == EINTR)
+                continue;
+            if (errno == EAGAIN || errno == EWOULDBLOCK)
+                return false;
+            throw std::runtime_error(std::string("[squaker.event] read failed: ") + std::strerror(errno));
+        }
+#else
+        return true;
+#endif
+    }
+
+    // 尝试写出缓存的数据
+    void EventLoop::flush(int fd) {
+#ifdef __linux__
+        Watch &watch = watches[fd];
+        size_t written = 0;
+        while (written < watch.output.size()) {
+            ssize_t n = ::write(fd, watch.output.data() + written, watch.output.size() - written);
+            if (n > 0) {
+                written += static_cast<size_t>(n);
+            } else if (n < 0 && errno == EINTR) {
+                continue;
+            } else if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+                break;
+            } else {
+                throw std::runtime_error(std::string("[squaker.event] write failed: ") + std::strerror(errno));
+            }
+        }
+        watch.output.erase(0, written);
+        if (watch.output.empty() && watch.closing) {
+            release(fd);
+        } else {
+            update_interest(fd);
+        }
+#endif
+    }
+
+    // 根据监听状态更新epoll注册
+    void EventLoop::update_interest(int fd) {
+#ifdef __linux__
+        Watch &watch = watches[fd];
+        unsigned int wanted = 0;
+        if (watch.onData.type != ValueType::Nil || watch.pid >= 0)
+            wanted |= EPOLLIN;
+        if (!watch.output.empty())
+            wanted |= EPOLLOUT;
+        if (wanted == watch.events)
+            return;
+
+        epoll_event event{};
+        event.events = wanted;
+        event.data.fd = fd;
+        int op = watch.events == 0 ? EPOLL_CTL_ADD : (wanted == 0 ? EPOLL_CTL_DEL : EPOLL_CTL_MOD);
+        if (epoll_ctl(pollFd, op, fd, &event) < 0) {
+            throw std::runtime_error("[squaker.event] Cannot poll fd " + std::to_string(fd) + ": " +
+                                     std::strerror(errno));
+        }
+        watch.events = wanted;
+#endif
+    }
+
+    // 停止监听并关闭
+    void EventLoop::release(int fd) {
+#ifdef __linux__
+        auto it = watches.find(fd);
+        if (it == watches.end())
+            return;
+        if (it->second.events != 0) {
+            epoll_ctl(pollFd, EPOLL_CTL_DEL, fd, nullptr);
+        }
+        watches.erase(it);
+        ::close(fd);
+#endif
+    }
+
+    // 是否还有让循环继续的事件
+    bool EventLoop::alive() const {
+        if (!timers.empty() || !fileJobs.empty() || !children.empty())
+            return true;
+        for (const auto &[fd, watch] : watches) {
+            if (watch.events != 0)
+                return true;
+        }
+        return false;
+    }
+
+} // namespace squ
\ No newline at end of file
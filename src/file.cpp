@@ -0,0 +1,265 @@
+#include "../include/file.h"
+#include "../include/identifier.h"
+#include "../include/mapped.h"
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+namespace squ {
+
+    using internal::TypeConverter;
+
+    // 打开文件
+    FileHandle::FileHandle(const std::string &path, const std::string &mode, size_t bufferSize)
+        : path(path), bufferSize(bufferSize > 0 ? bufferSize : kDefaultBuffer) {
+        std::string base = mode;
+        base.erase(std::remove(base.begin(), base.end(), 'b'), base.end());
+        const char *cmode = nullptr;
+        if (base == "r") {
+            cmode = "rb";
+            readable = true;
+        } else if (base == "w") {
+            cmode = "wb";
+            writable = true;
+        } else if (base == "a") {
+            cmode = "ab";
+            writable = true;
+        } else {
+            throw std::runtime_error("[squaker.io] Unsupported file mode: " + mode);
+        }
+        file = std::fopen(path.c_str(), cmode);
+        if (!file) {
+            throw std::runtime_error("[squaker.io] Failed to open file: " + path);
+        }
+        std::setvbuf(file, nullptr, _IONBF, 0); // 缓冲由本对象负责
+        if (writable) {
+            output.reserve(this->bufferSize);
+        }
+    }
+
+    FileHandle::~FileHandle() {
+        if (file) {
+            if (!output.empty())
+                std::fwrite(output.data(), 1, output.size(), file);
+            std::fclose(file);
+        }
+    }
+
+    // 检查文件仍然打开
+    void FileHandle::ensure_open() const {
+        if (!file) {
+            throw std::runtime_error("[squaker.io] File is closed: " + path);
+        }
+    }
+
+    // 读入下一块
+    bool FileHandle::fill() {
+        size_t remaining = end - pos;
+        size_t capacity = block ? block->size() : bufferSize;
+        if (remaining == capacity) {
+            capacity *= 2; // 一行比整块还长
+        }
+        if (block && block.use_count() == 1 && block->size() == capacity) {
+            // 没有行视图引用这个块，原地复用
+            std::memmove(block->data(), block->data() + pos, remaining);
+        } else {
+            auto next = std::make_shared<std::string>(capacity, '\0');
+            if (remaining > 0)
+                std::memcpy(next->data(), block->data() + pos, remaining);
+            block = std::move(next);
+        }
+        pos = 0;
+        end = remaining;
+
+        size_t n = std::fread(block->data() + end, 1, capacity - end, file);
+        if (n == 0) {
+            if (std::ferror(file)) {
+                throw std::runtime_error("[squaker.io] Failed to read file: " + path);
+            }
+            eof = true;
+            return false;
+        }
+        end += n;
+        return true;
+    }
+
+    // 读取一行
+    bool FileHandle::read_line(std::string_view &line) {
+        ensure_open();
+        if (!readable) {
+            throw std::runtime_error("[squaker.io] File not opened for reading: " + path);
+        }
+        size_t scanned = 0; // 已经确认没有换行的长度，续读后不再重复扫描
+        while (true) {
+            const char *begin = block ? block->data() + pos : nullptr;
+            const void *nl = block ? std::memchr(begin + scanned, '\n', end - pos - scanned) : nullptr;
+            if (nl) {
+                size_t len = static_cast<size_t>(static_cast<const char *>(nl) - begin);
+                pos += len + 1;
+                if (len > 0 && begin[len - 1] == '\r')
+                    len--;
+                line = std::string_view(begin, len);
+                return true;
+            }
+            if (eof || !(scanned = end - pos, fill())) {
+                if (end == pos)
+                    return false;
+                // 最后一行没有换行符
+                size_t len = end - pos;
+                if (block->data()[pos + len - 1] == '\r')
+                    len--;
+                line = std::string_view(block->data() + pos, len);
+                pos = end;
+                return true;
+            }
+        }
+    }
+
+    // 行视图：与块缓冲区共享所有权
+    ValueData FileHandle::line_view(std::string_view line) const {
+        return ValueData{ValueType::Object, false,
+                         std::shared_ptr<ObjectData>(std::make_shared<ByteView>(block, line))};
+    }
+
+    // 读取剩余的全部内容
+    std::string FileHandle::read_all() {
+        ensure_open();
+        if (!readable) {
+            throw std::runtime_error("[squaker.io] File not opened for reading: " + path);
+        }
+        std::string result(block ? block->data() + pos : nullptr, end - pos);
+        pos = end;
+        char chunk[kDefaultBuffer];
+        size_t n;
+        while ((n = std::fread(chunk, 1, sizeof(chunk), file)) > 0) {
+            result.append(chunk, n);
+        }
+        if (std::ferror(file)) {
+            throw std::runtime_error("[squaker.io] Failed to read file: " + path);
+        }
+        eof = true;
+        return result;
+    }
+
+    // 写入
+    void FileHandle::write(std::string_view data) {
+        ensure_open();
+        if (!writable) {
+            throw std::runtime_error("[squaker.io] File not opened for writing: " + path);
+        }
+        if (output.size() + data.size() > bufferSize) {
+            flush();
+            if (data.size() >= bufferSize) {
+                // 大块数据直接落盘，不经过缓冲区
+                if (std::fwrite(data.data(), 1, data.size(), file) != data.size()) {
+                    throw std::runtime_error("[squaker.io] Failed to write file: " + path);
+                }
+                return;
+            }
+        }
+        output.append(data);
+    }
+
+    // 把缓冲区写入文件
+    void FileHandle::flush() {
+        ensure_open();
+        if (output.empty())
+            return;
+        if (std::fwrite(output.data(), 1, output.size(), file) != output.size()) {
+            throw std::runtime_error("[squaker.io] Failed to write file: " + path);
+        }
+        output.clear();
+    }
+
+    // 关闭文件
+    void FileHandle::close() {
+        if (!file)
+            return;
+        if (writable)
+            flush();
+        std::fclose(file);
+        file = nullptr;
+        block.reset();
+        pos = end = 0;
+    }
+
+    // 文件句柄成员
+    ValueData FileHandle::member(const std::string &name) {
+        auto self = std::static_pointer_cast<FileHandle>(shared_from_this());
+        if (name == "read_line") {
+            return make_function([self]() {
+                std::string_view line;
+                if (!self->read_line(line))
+                    return ValueData{ValueType::Nil};
+                return ValueData{ValueType::String, false, std::string(line)};
+            });
+        }
+        if (name == "lines") {
+            return make_function([self]() {
+                return ValueData{ValueType::Object, false, std::shared_ptr<ObjectData>(std::make_shared<FileLines>(self))};
+            });
+        }
+        if (name == "read") {
+            return make_function([self]() { return self->read_all(); });
+        }
+        if (name == "write") {
+            // 可变参数：字符串与视图按原样写入，其他值按字符串表示写入
+            return ValueData{ValueType::Function, false, [self](std::vector<ValueData> &args, VM &) -> ValueData {
+                                 for (const auto &arg : args) {
+                                     std::string_view bytes;
+                                     if (arg.type == ValueType::String) {
+                                         self->write(std::get<StringData>(arg.value).view());
+                                     } else if (arg.type == ValueType::Char) {
+                                         self->write(std::string_view(&std::get<char>(arg.value), 1));
+                                     } else if (arg.type == ValueType::Object &&
+                                                std::get<std::shared_ptr<ObjectData>>(arg.value)->bytes(bytes)) {
+                                         self->write(bytes);
+                                     } else {
+                                         self->write(arg.string());
+                                     }
+                                 }
+                                 return ValueData{ValueType::Nil};
+                             }};
+        }
+        if (name == "flush") {
+            return make_function([self]() { self->flush(); });
+        }
+        if (name == "close") {
+            return make_function([self]() { self->close(); });
+        }
+        return ObjectData::member(name);
+    }
+
+    // 预读一行
+    void FileLines::prefetch() {
+        std::string_view line;
+        if (handle->read_line(line)) {
+            pending = handle->line_view(line);
+        } else {
+            pending = ValueData{ValueType::Nil};
+        }
+        ready = true;
+    }
+
+    // 行迭代器成员
+    ValueData FileLines::member(const std::string &name) {
+        auto self = std::static_pointer_cast<FileLines>(shared_from_this());
+        if (name == "next") {
+            return make_function([self]() {
+                if (!self->ready)
+                    self->prefetch();
+                self->ready = false;
+                return std::move(self->pending);
+            });
+        }
+        if (name == "done") {
+            return make_function([self]() {
+                if (!self->ready)
+                    self->prefetch();
+                return self->pending.type == ValueType::Nil;
+            });
+        }
+        return ObjectData::member(name);
+    }
+
+} // namespace squ
\ No newline at end of file
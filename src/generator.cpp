@@ -0,0 +1,95 @@
+#include "../include/generator.h"
+#include "../include/control.h"
+#include <stdexcept>
+
+namespace squ {
+
+    // 成员访问：返回绑定到当前生成器的函数
+    ValueData GeneratorData::member(const std::string &name) {
+        auto self = std::static_pointer_cast<GeneratorData>(shared_from_this());
+        if (name == "next") {
+            return ValueData{ValueType::Function, false, [self](std::vector<ValueData> &args, VM &vm) -> ValueData {
+                                 if (args.size() > 1) {
+                                     throw std::runtime_error("[squaker.generator] next expects at most 1 argument");
+                                 }
+                                 return self->next(vm, args.empty() ? ValueData{ValueType::Nil} : args[0]);
+                             }};
+        }
+        if (name == "done") {
+            return ValueData{ValueType::Function, false, [self](std::vector<ValueData> &args, VM &vm) -> ValueData {
+                                 if (!args.empty()) {
+                                     throw std::runtime_error("[squaker.generator] done expects no arguments");
+                                 }
+                                 return ValueData{ValueType::Bool, false, self->done(vm)};
+                             }};
+        }
+        return ObjectData::member(name);
+    }
+
+    // 取下一个产出值
+    ValueData GeneratorData::next(VM &vm, ValueData sent) {
+        if (!ready && !finished) {
+            advance(vm, std::move(sent));
+        }
+        if (!ready) {
+            return ValueData{ValueType::Nil}; // 已耗尽
+        }
+        ready = false;
+        return std::move(value);
+    }
+
+    // 是否已经耗尽
+    bool GeneratorData::done(VM &vm) {
+        if (!ready && !finished) {
+            advance(vm, ValueData{ValueType::Nil});
+        }
+        return !ready;
+    }
+
+    // 恢复执行直到下一个yield或函数结束
+    void GeneratorData::advance(VM &vm, ValueData sent) {
+        if (running) {
+            throw std::runtime_error("[squaker.generator] Generator is already running");
+        }
+        running = true;
+
+        // 在调用者的栈上压入新帧，把保存的局部变量搬回去
+        VMGuard guard(vm, locals.size());
+        for (size_t i = 0; i < locals.size(); i++) {
+            vm.local(i) = std::move(locals[i]);
+        }
+        vm.callStack.back().coroutine = &state;
+        state.sent = std::move(sent);
+        state.resuming = started;
+        started = true;
+
+        try {
+            body->execute(vm); // 函数体的值不会被使用
+            finished = true;
+        } catch (YieldException &e) {
+            // 挂起：帧搬回对象，恢复路径已由沿途节点记录
+            value = std::move(e.value);
+            ready = true;
+            for (size_t i = 0; i < locals.size(); i++) {
+                locals[i] = std::move(vm.local(i));
+            }
+        } catch (const ReturnException &) {
+            finished = true; // return 结束生成器，返回值被忽略
+        } catch (...) {
+            finished = true;
+            running = false;
+            locals.clear();
+            state = Coroutine{};
+            throw;
+        }
+        running = false;
+
+        if (finished) {
+            // 生成器结束后不再需要帧
+            locals.clear();
+            locals.shrink_to_fit();
+            state = Coroutine{};
+        }
+    }
+
+} // namespace squ
\ No newline at end of file
@@ -0,0 +1,108 @@
+#include "../include/intrinsic.h"
+#include <deque>
+#include <mutex>
+#include <stdexcept>
+
+namespace squ {
+
+    namespace {
+
+        // 标准输出：值只读地取得后直接格式化进虚拟机的输出缓冲区，不拷贝
+        ValueData IntrinsicPrint(const std::vector<std::unique_ptr<ExprNode>> &args, VM &vm) {
+            for (const auto &arg : args) {
+                ValueData scratch;
+                vm.out.format(arg->evaluate_ref(vm, scratch));
+                vm.out.put(' ');
+            }
+            vm.out.newline();
+            return ValueData{ValueType::Nil};
+        }
+
+        // 刷新输出缓冲区
+        ValueData IntrinsicFlush(const std::vector<std::unique_ptr<ExprNode>> &, VM &vm) {
+            vm.out.flush();
+            return ValueData{ValueType::Nil};
+        }
+
+        // 打印调用栈（先刷新缓冲区，保证输出顺序）
+        ValueData IntrinsicStack(const std::vector<std::unique_ptr<ExprNode>> &, VM &vm) {
+            vm.out.flush();
+            vm.printStack();
+            return ValueData{ValueType::Nil};
+        }
+
+        // 值的类型名
+        ValueData IntrinsicType(const std::vector<std::unique_ptr<ExprNode>> &args, VM &vm) {
+            ValueData argValue = args[0]->evaluate(vm);
+            if (argValue.type == ValueType::Object) {
+                return ValueData{ValueType::String, false,
+                                 std::get<std::shared_ptr<ObjectData>>(argValue.value)->type_name()};
+            }
+            return ValueData{ValueType::String, false, TypeName(argValue.type)};
+        }
+
+        // 内建函数注册表：只在解析期查找，deque 保证已注册项的地址不变
+        struct IntrinsicTable {
+            std::mutex mutex;
+            std::deque<IntrinsicInfo> entries;
+
+            IntrinsicTable() {
+                add({"print", IntrinsicPrint, {}, 0, IntrinsicInfo::npos});
+                add({"flush", IntrinsicFlush, {}, 0, 0});
+                add({"stack", IntrinsicStack, {}, 0, 0});
+                add({"type", IntrinsicType, {}, 1, 1});
+            }
+
+            const IntrinsicInfo *find(const std::string &name) const {
+                for (const auto &entry : entries) {
+                    if (entry.name == name)
+                        return &entry;
+                }
+                return nullptr;
+            }
+
+            void add(IntrinsicInfo info) {
+                if (find(info.name)) {
+                    throw std::runtime_error("[squaker.intrinsic] Intrinsic already registered: @" + info.name);
+                }
+                entries.push_back(std::move(info));
+            }
+        };
+
+        IntrinsicTable &Intrinsics() {
+            static IntrinsicTable table;
+            return table;
+        }
+
+    } // namespace
+
+    // 注册语法级内建函数
+    void RegisterIntrinsic(std::string name, Intrinsic call, size_t minArgs, size_t maxArgs) {
+        if (!call) {
+            throw std::runtime_error("[squaker.intrinsic] Null intrinsic: @" + name);
+        }
+        IntrinsicTable &table = Intrinsics();
+        std::lock_guard<std::mutex> lock(table.mutex);
+        table.add({std::move(name), call, {}, minArgs, maxArgs});
+    }
+
+    // 注册按C++签名包装的内建函数
+    void RegisterIntrinsic(std::string name, ValueData function) {
+        const NativeFunction *native = AsNative(function);
+        if (!native) {
+            throw std::runtime_error("[squaker.intrinsic] Intrinsic must be a wrapped native function: @" + name);
+        }
+        size_t arity = native->arity;
+        IntrinsicTable &table = Intrinsics();
+        std::lock_guard<std::mutex> lock(table.mutex);
+        table.add({std::move(name), nullptr, std::move(function), arity, arity});
+    }
+
+    // 按名字查找内建函数
+    const IntrinsicInfo *FindIntrinsic(const std::string &name) {
+        IntrinsicTable &table = Intrinsics();
+        std::lock_guard<std::mutex> lock(table.mutex);
+        return table.find(name);
+    }
+
+} // namespace squ
\ No newline at end of file
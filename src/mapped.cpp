@@ -0,0 +1,202 @@
+#include "../include/mapped.h"
+#include "../include/identifier.h"
+#include <stdexcept>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace squ {
+
+    using internal::TypeConverter;
+
+    // 映射整个文件
+    MappedFile::MappedFile(const std::string &path) {
+#ifdef _WIN32
+        HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                                  FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+        if (file == INVALID_HANDLE_VALUE) {
+            throw std::runtime_error("[squaker.io] Failed to open file: " + path);
+        }
+        LARGE_INTEGER fileSize;
+        if (!GetFileSizeEx(file, &fileSize)) {
+            CloseHandle(file);
+            throw std::runtime_error("[squaker.io] Failed to stat file: " + path);
+        }
+        fileHandle = file;
+        length = static_cast<size_t>(fileSize.QuadPart);
+        if (length == 0)
+            return;
+        HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (!mapping) {
+            CloseHandle(file);
+            throw std::runtime_error("[squaker.io] Failed to map file: " + path);
+        }
+        mappingHandle = mapping;
+        ptr = static_cast<const char *>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+        if (!ptr) {
+            CloseHandle(mapping);
+            CloseHandle(file);
+            throw std::runtime_error("[squaker.io] Failed to map file: " + path);
+        }
+#else
+        int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) {
+            throw std::runtime_error("[squaker.io] Failed to open file: " + path);
+        }
+        struct stat st;
+        if (fstat(fd, &st) < 0) {
+            ::close(fd);
+            throw std::runtime_error("[squaker.io] Failed to stat file: " + path);
+        }
+        length = static_cast<size_t>(st.st_size);
+        if (length > 0) {
+            void *p = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (p == MAP_FAILED) {
+                ::close(fd);
+                throw std::runtime_error("[squaker.io] Failed to map file: " + path);
+            }
+            madvise(p, length, MADV_SEQUENTIAL); // 多为顺序扫描，提示内核预读
+            ptr = static_cast<const char *>(p);
+        }
+        ::close(fd); // 映射建立后不再需要描述符
+#endif
+    }
+
+    MappedFile::~MappedFile() {
+#ifdef _WIN32
+        if (ptr)
+            UnmapViewOfFile(ptr);
+        if (mappingHandle)
+            CloseHandle(mappingHandle);
+        if (fileHandle)
+            CloseHandle(fileHandle);
+#else
+        if (ptr)
+            munmap(const_cast<char *>(ptr), length);
+#endif
+    }
+
+    // 生成子视图
+    ValueData ByteView::slice(size_t start, size_t end) const {
+        if (start > end || end > content.size()) {
+            throw std::out_of_range("[squaker.view] Slice out of range: [" + std::to_string(start) + ", " +
+                                    std::to_string(end) + ") of " + std::to_string(content.size()));
+        }
+        return ValueData{ValueType::Object, false,
+                         std::shared_ptr<ObjectData>(std::make_shared<ByteView>(owner, content.substr(start, end - start)))};
+    }
+
+    // 子串
+    ValueData SliceBytes(const ValueData &source, size_t start, size_t end) {
+        if (source.type == ValueType::Object) {
+            auto &object = std::get<std::shared_ptr<ObjectData>>(source.value);
+            if (auto *view = dynamic_cast<ByteView *>(object.get()))
+                return view->slice(start, end);
+        }
+        std::string_view whole = TypeConverter<std::string_view>::convert(source);
+        if (start > end || end > whole.size()) {
+            throw std::out_of_range("[squaker.string] Slice out of range: [" + std::to_string(start) + ", " +
+                                    std::to_string(end) + ") of " + std::to_string(whole.size()));
+        }
+        if (source.type == ValueType::String)
+            return ValueData{ValueType::String, false, std::get<StringData>(source.value).slice(start, end)};
+        return ValueData{ValueType::String, false, std::string(whole.substr(start, end - start))};
+    }
+
+    // 转为字节视图
+    ValueData MakeView(const ValueData &source) {
+        if (source.type == ValueType::Object &&
+            dynamic_cast<ByteView *>(std::get<std::shared_ptr<ObjectData>>(source.value).get())) {
+            return source;
+        }
+        if (source.type == ValueType::String) {
+            auto &text = std::get<StringData>(source.value);
+            return ValueData{ValueType::Object, false,
+                             std::shared_ptr<ObjectData>(std::make_shared<ByteView>(text.owner(), text.view()))};
+        }
+        auto owner = std::make_shared<const std::string>(TypeConverter<std::string_view>::convert(source));
+        std::string_view content(*owner);
+        return ValueData{ValueType::Object, false,
+                         std::shared_ptr<ObjectData>(std::make_shared<ByteView>(std::move(owner), content))};
+    }
+
+    // 视图成员
+    ValueData ByteView::member(const std::string &name) {
+        auto self = std::static_pointer_cast<const ByteView>(shared_from_this());
+        if (name == "length") {
+            return make_function([self]() { return static_cast<long long>(self->content.size()); });
+        }
+        if (name == "at") {
+            return make_function([self](long long i) {
+                if (i < 0 || static_cast<size_t>(i) >= self->content.size()) {
+                    throw std::out_of_range("[squaker.view] Index out of range: " + std::to_string(i));
+                }
+                return self->content[static_cast<size_t>(i)];
+            });
+        }
+        if (name == "slice") {
+            return make_function([self](long long start, long long end) {
+                if (start < 0 || end < 0) {
+                    throw std::out_of_range("[squaker.view] Negative slice bound");
+                }
+                return self->slice(static_cast<size_t>(start), static_cast<size_t>(end));
+            });
+        }
+        if (name == "find") {
+            return ValueData{ValueType::Function, false, [self](std::vector<ValueData> &args, VM &) -> ValueData {
+                                 if (args.empty() || args.size() > 2) {
+                                     throw std::runtime_error("[squaker.view] find expects 1 or 2 arguments");
+                                 }
+                                 std::string_view sub = TypeConverter<std::string_view>::convert(args[0]);
+                                 long long from = args.size() > 1 ? TypeConverter<long long>::convert(args[1]) : 0;
+                                 size_t pos = self->content.find(sub, static_cast<size_t>(std::max(from, 0LL)));
+                                 return ValueData{ValueType::Integer, false,
+                                                  pos == std::string_view::npos ? -1LL : static_cast<long long>(pos)};
+                             }};
+        }
+        if (name == "lines") {
+            return make_function([self]() {
+                return ValueData{ValueType::Object, false,
+                                 std::shared_ptr<ObjectData>(std::make_shared<LineIterator>(self, self->content))};
+            });
+        }
+        if (name == "str") {
+            return make_function([self]() { return std::string(self->content); });
+        }
+        return ObjectData::member(name);
+    }
+
+    // 行迭代器成员
+    ValueData LineIterator::member(const std::string &name) {
+        auto self = std::static_pointer_cast<LineIterator>(shared_from_this());
+        if (name == "next") {
+            return make_function([self]() {
+                if (self->rest.empty()) {
+                    return ValueData{ValueType::Nil};
+                }
+                size_t eol = self->rest.find('\n');
+                std::string_view line = self->rest.substr(0, eol);
+                self->rest = eol == std::string_view::npos ? std::string_view() : self->rest.substr(eol + 1);
+                if (!line.empty() && line.back() == '\r') {
+                    line.remove_suffix(1);
+                }
+                // 行视图共享源视图的所有者，不拷贝内容
+                std::string_view whole;
+                self->source->bytes(whole);
+                size_t start = static_cast<size_t>(line.data() - whole.data());
+                return self->source->slice(start, start + line.size());
+            });
+        }
+        if (name == "done") {
+            return make_function([self]() { return self->rest.empty(); });
+        }
+        return ObjectData::member(name);
+    }
+
+} // namespace squ
\ No newline at end of file
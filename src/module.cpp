@@ -1,5 +1,16 @@
 #include "../include/module.h"
+#include "../include/array.h"
+#include "../include/builder.h"
+#include "../include/event.h"
+#include "../include/file.h"
 #include "../include/identifier.h"
+#include "../include/mapped.h"
+#include "../include/parser.h"
+#include "../include/record.h"
+#include "../include/squaker.h"
+#include "../include/token.h"
+#include <algorithm>
+#include <cctype>
 #include <cmath>
 #include <stdexcept>
 #include <fstream>
@@ -7,202 +18,680 @@
 #include <thread>
 #include <ctime>
 #include <chrono>
+#include <memory>
+#include <mutex>
+#include <filesystem>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#ifdef _WIN32
+#include <process.h>
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <dlfcn.h>
+#include <unistd.h>
+#endif
 
 namespace squ {
 
-    IdentifierData Module(std::string module_name) {
-        // 模块注册逻辑
-        // 数学模块
-        if (module_name == "math") {
-            return Namespace("math",
-                Function("sin", static_cast<double (*)(double)>(std::sin)),
-                Function("cos", static_cast<double (*)(double)>(std::cos)),
-                Function("tan", static_cast<double (*)(double)>(std::tan)),
-                Function("asin", static_cast<double (*)(double)>(std::asin)),
-                Function("acos", static_cast<double (*)(double)>(std::acos)),
-                Function("atan", static_cast<double (*)(double)>(std::atan)),
-                Function("sqrt", static_cast<double (*)(double)>(std::sqrt)),
-                Function("pow", static_cast<double (*)(double, double)>(std::pow)),
-                Function("log", static_cast<double (*)(double)>(std::log)),
-                Function("exp", static_cast<double (*)(double)>(std::exp)),
-                Function("abs", static_cast<double (*)(double)>(std::abs)),
-                Function("ceil", static_cast<double (*)(double)>(std::ceil)),
-                Function("floor", static_cast<double (*)(double)>(std::floor)),
-                Function("round", static_cast<double (*)(double)>(std::round)),
-                Function("fmod", static_cast<double (*)(double, double)>(std::fmod)),
-                Function("hypot", static_cast<double (*)(double, double)>(std::hypot)),
-                Function("max", static_cast<double (*)(double, double)>(std::fmax)),
-                Function("min", static_cast<double (*)(double, double)>(std::fmin)),
-                Function("atan2", static_cast<double (*)(double, double)>(std::atan2)),
-                Function("ceil", static_cast<double (*)(double)>(std::ceil)),
-                Function("floor", static_cast<double (*)(double)>(std::floor)),
-                Function("cosh", static_cast<double (*)(double)>(std::cosh)),
-                Function("sinh", static_cast<double (*)(double)>(std::sinh)),
-                Function("tanh", static_cast<double (*)(double)>(std::tanh)),
-                Constant("PI", 3.14159265358979323846),
-                Constant("E", 2.71828182845904523536),
-                Constant("LN2", 0.69314718055994530942),
-                Constant("LN10", 2.30258509299404568402),
-                Constant("LOG2E", 1.44269504088896340736),
-                Constant("LOG10E", 0.43429448190325182765)
-            );
-        } 
-        // 字符串模块
-        else if (module_name == "string") {
-            return Namespace("string",
-                Function("length", [](const std::string &s) { return static_cast<long long>(s.length()); }),
-                Function("concat", [](const std::string &a, const std::string &b) { return a + b; }),
-                Function("substr", [](const std::string &s, long long start, long long end) {
-                    return s.substr(static_cast<size_t>(start), static_cast<size_t>(end - start));
-                }),
-                Function("upper", [](const std::string &s) {
-                    std::string result = s;
-                    for (auto &c : result) c = static_cast<char>(std::toupper(c));
-                    return result;
-                }),
-                Function("lower", [](const std::string &s) {
-                    std::string result = s;
-                    for (auto &c : result) c = static_cast<char>(std::tolower(c));
-                    return result;
-                }),
-                Function("find", [](const std::string &s, const std::string &sub) {
-                    size_t pos = s.find(sub);
-                    return pos != std::string::npos ? static_cast<long long>(pos) : -1;
-                }),
-                Function("replace", [](const std::string &s, const std::string &old_sub, const std::string &new_sub) {
-                    std::string result = s;
-                    size_t pos = 0;
-                    while ((pos = result.find(old_sub, pos)) != std::string::npos) {
-                        result.replace(pos, old_sub.length(), new_sub);
-                        pos += new_sub.length();
-                    }
-                    return result;
-                }),
-                Function("split", [](const std::string &s, const std::string &delimiter) {
-                    std::vector<std::string> result;
-                    size_t start = 0, end;
-                    while ((end = s.find(delimiter, start)) != std::string::npos) {
-                        result.push_back(s.substr(start, end - start));
-                        start = end + delimiter.length();
-                    }
-                    result.push_back(s.substr(start));
-                    return result;
-                }),
-                Function("join", [](std::vector<std::string> parts, const std::string &delimiter) {
-                    std::string result;
-                    for (size_t i = 0; i < parts.size(); ++i) {
-                        result += parts[i];
-                        if (i < parts.size() - 1) {
-                            result += delimiter;
-                        }
-                    }
-                    return result;
-                }),
-                Function("trim", [](const std::string &s) {
-                    size_t first = s.find_first_not_of(" \t\n\r");
-                    size_t last = s.find_last_not_of(" \t\n\r");
-                    return (first == std::string::npos || last == std::string::npos) ? "" : s.substr(first, last - first + 1);
-                }),
-                Function("reverse", [](const std::string &s) {
-                    return std::string(s.rbegin(), s.rend());
-                })
-            );
-        }
-        // 表处理模块
-        else if (module_name == "table") {
-            return Namespace("table",
-                Function("remove", [](std::map<std::string, std::string> table, const std::string &key) {
-                    table.erase(key);
-                }),
-                Function("keys", [](std::map<std::string, std::string> table) {
-                    std::vector<std::string> keys;
-                    for (const auto &pair : table) {
-                        keys.push_back(pair.first);
-                    }
-                    return keys;
-                }),
-                Function("values", [](std::map<std::string, std::string> table) {
-                    std::vector<std::string> values;
-                    for (const auto &pair : table) {
-                        values.push_back(pair.second);
-                    }
-                    return values;
-                }),
-                Function("size", [](std::map<std::string, std::string> table) {
-                    return static_cast<long long>(table.size());
-                })
-            );
-        }
-        // 文件输入输出模块
-        else if (module_name == "io") {
-            return Namespace("io",
-                Function("read_file", [](const std::string &filename) {
-                    std::ifstream file(filename);
-                    if (!file.is_open()) {
-                        throw std::runtime_error("[squaker.io] Failed to open file: " + filename);
-                    }
-                    std::stringstream buffer;
-                    buffer << file.rdbuf();
-                    return buffer.str();
-                }),
-                Function("write_file", [](const std::string &filename, const std::string &content) {
-                    std::ofstream file(filename);
-                    if (!file.is_open()) {
-                        throw std::runtime_error("[squaker.io] Failed to open file for writing: " + filename);
+    // 数学模块
+    static IdentifierData MathModule() {
+        return Namespace("math",
+            Function("sin", static_cast<double (*)(double)>(std::sin)),
+            Function("cos", static_cast<double (*)(double)>(std::cos)),
+            Function("tan", static_cast<double (*)(double)>(std::tan)),
+            Function("asin", static_cast<double (*)(double)>(std::asin)),
+            Function("acos", static_cast<double (*)(double)>(std::acos)),
+            Function("atan", static_cast<double (*)(double)>(std::atan)),
+            Function("sqrt", static_cast<double (*)(double)>(std::sqrt)),
+            Function("pow", static_cast<double (*)(double, double)>(std::pow)),
+            Function("log", static_cast<double (*)(double)>(std::log)),
+            Function("exp", static_cast<double (*)(double)>(std::exp)),
+            Function("abs", static_cast<double (*)(double)>(std::abs)),
+            Function("ceil", static_cast<double (*)(double)>(std::ceil)),
+            Function("floor", static_cast<double (*)(double)>(std::floor)),
+            Function("round", static_cast<double (*)(double)>(std::round)),
+            Function("fmod", static_cast<double (*)(double, double)>(std::fmod)),
+            Function("hypot", static_cast<double (*)(double, double)>(std::hypot)),
+            Function("max", static_cast<double (*)(double, double)>(std::fmax)),
+            Function("min", static_cast<double (*)(double, double)>(std::fmin)),
+            Function("atan2", static_cast<double (*)(double, double)>(std::atan2)),
+            Function("ceil", static_cast<double (*)(double)>(std::ceil)),
+            Function("floor", static_cast<double (*)(double)>(std::floor)),
+            Function("cosh", static_cast<double (*)(double)>(std::cosh)),
+            Function("sinh", static_cast<double (*)(double)>(std::sinh)),
+            Function("tanh", static_cast<double (*)(double)>(std::tanh)),
+            Constant("PI", 3.14159265358979323846),
+            Constant("E", 2.71828182845904523536),
+            Constant("LN2", 0.69314718055994530942),
+            Constant("LN10", 2.30258509299404568402),
+            Constant("LOG2E", 1.44269504088896340736),
+            Constant("LOG10E", 0.43429448190325182765)
+        );
+    }
+
+    // 字符串模块
+    static IdentifierData StringModule() {
+        // 只读参数使用 std::string_view，字符串与字节视图（如 io.map_file）都可直接传入而不拷贝
+        return Namespace("string",
+            Function("length", [](std::string_view s) { return static_cast<long long>(s.length()); }),
+            Native("concat", [](std::vector<ValueData> &args, VM &) {
+                // 任意个参数一次拼接，只分配一次
+                std::vector<std::string_view> parts;
+                parts.reserve(args.size());
+                size_t total = 0;
+                for (const auto &arg : args) {
+                    parts.push_back(internal::TypeConverter<std::string_view>::convert(arg));
+                    total += parts.back().size();
+                }
+                std::string result;
+                result.reserve(total);
+                for (auto part : parts)
+                    result.append(part);
+                return ValueData{ValueType::String, false, std::move(result)};
+            }),
+            Function("builder", []() {
+                // 字符串构建器：重复追加为线性时间
+                return ValueData{ValueType::Object, false,
+                                 std::shared_ptr<ObjectData>(std::make_shared<StringBuilder>())};
+            }),
+            Native("substr", [](std::vector<ValueData> &args, VM &) {
+                // substr(s, start, end)：字节视图返回共享缓冲区的子视图，字符串返回共享内容的切片
+                if (args.size() != 3) {
+                    throw std::runtime_error("[squaker.string] substr expects 3 arguments");
+                }
+                size_t length = internal::TypeConverter<std::string_view>::convert(args[0]).size();
+                long long start = internal::TypeConverter<long long>::convert(args[1]);
+                long long end = internal::TypeConverter<long long>::convert(args[2]);
+                if (start < 0 || end < start) {
+                    throw std::out_of_range("[squaker.string] Invalid substr range");
+                }
+                return SliceBytes(args[0], std::min(static_cast<size_t>(start), length),
+                                  std::min(static_cast<size_t>(end), length));
+            }),
+            Native("view", [](std::vector<ValueData> &args, VM &) {
+                // 与字符串共享内容块（不拷贝），结果按对象传递
+                if (args.size() != 1) {
+                    throw std::runtime_error("[squaker.string] view expects 1 argument");
+                }
+                return MakeView(args[0]);
+            }),
+            Function("upper", [](std::string_view s) {
+                std::string result(s);
+                for (auto &c : result) c = static_cast<char>(std::toupper(c));
+                return result;
+            }),
+            Function("lower", [](std::string_view s) {
+                std::string result(s);
+                for (auto &c : result) c = static_cast<char>(std::tolower(c));
+                return result;
+            }),
+            Function("find", [](std::string_view s, std::string_view sub) {
+                size_t pos = s.find(sub);
+                return pos != std::string_view::npos ? static_cast<long long>(pos) : -1;
+            }),
+            Function("replace", [](std::string_view s, std::string_view old_sub, std::string_view new_sub) {
+                std::string result(s);
+                size_t pos = 0;
+                while ((pos = result.find(old_sub, pos)) != std::string::npos) {
+                    result.replace(pos, old_sub.length(), new_sub);
+                    pos += new_sub.length();
+                }
+                return result;
+            }),
+            Native("split", [](std::vector<ValueData> &args, VM &) {
+                // split(s, delimiter)：结果为紧凑数组；各段与源字符串或字节视图共享内容
+                if (args.size() != 2) {
+                    throw std::runtime_error("[squaker.string] split expects 2 arguments");
+                }
+                std::string_view s = internal::TypeConverter<std::string_view>::convert(args[0]);
+                std::string_view delimiter = internal::TypeConverter<std::string_view>::convert(args[1]);
+                if (delimiter.empty()) {
+                    throw std::runtime_error("[squaker.string] Delimiter must not be empty");
+                }
+                std::vector<ValueData> result;
+                size_t start = 0, end;
+                while ((end = s.find(delimiter, start)) != std::string_view::npos) {
+                    result.push_back(SliceBytes(args[0], start, end));
+                    start = end + delimiter.length();
+                }
+                result.push_back(SliceBytes(args[0], start, s.size()));
+                return ValueData{ValueType::Array, false, std::move(result)};
+            }),
+            Function("join", [](std::vector<std::string_view> parts, std::string_view delimiter) {
+                std::string result;
+                for (size_t i = 0; i < parts.size(); ++i) {
+                    result += parts[i];
+                    if (i < parts.size() - 1) {
+                        result += delimiter;
                     }
-                    file << content;
-                })
-            );
-        }
-        // 操作系统工具模块
-        else if (module_name == "os") {
-            return Namespace("os",
-                Function("system", [](const std::string &command) {
-                    int result = std::system(command.c_str());
-                    return result;
-                }),
-                Function("getenv", [](const std::string &name) {
-                    const char *value = std::getenv(name.c_str());
-                    return value ? std::string(value) : "";
-                }),
-                Function("exit", [](long long code) {
-                    std::exit(static_cast<int>(code));
-                }),
-                Function("sleep", [](long long seconds) {
-                    std::this_thread::sleep_for(std::chrono::seconds(static_cast<int>(seconds)));
-                }),
-                Function("clock", []() {
-                    return static_cast<long long>(std::clock() / CLOCKS_PER_SEC);
-                }),
-                Function("remove" , [](const std::string &filename) {
-                    if (std::remove(filename.c_str()) != 0) {
-                        throw std::runtime_error("[squaker.os] Failed to remove file: " + filename);
+                }
+                return result;
+            }),
+            Native("trim", [](std::vector<ValueData> &args, VM &) {
+                if (args.size() != 1) {
+                    throw std::runtime_error("[squaker.string] trim expects 1 argument");
+                }
+                std::string_view s = internal::TypeConverter<std::string_view>::convert(args[0]);
+                size_t first = s.find_first_not_of(" \t\n\r");
+                size_t last = s.find_last_not_of(" \t\n\r");
+                return (first == std::string_view::npos || last == std::string_view::npos)
+                           ? SliceBytes(args[0], 0, 0)
+                           : SliceBytes(args[0], first, last + 1);
+            }),
+            Function("reverse", [](std::string_view s) {
+                return std::string(s.rbegin(), s.rend());
+            })
+        );
+    }
+
+    // 表处理模块
+    static IdentifierData TableModule() {
+        return Namespace("table",
+            // 表参数按引用传入：传入变量时不拷贝整张表，remove/push 直接修改调用方的表
+            Function("remove", [](TableData &table, const ValueData &key) {
+                bool removed = table.erase(key);
+                std::string_view name;
+                if (AsBytes(key, name))
+                    removed = table.erase_dot(std::string(name)) || removed;
+                return removed;
+            }),
+            Function("keys", [](const TableData &table) {
+                std::vector<ValueData> keys;
+                keys.reserve(table.length());
+                table.for_each_index([&keys](const ValueData &key, const ValueData &) {
+                    keys.push_back(key);
+                });
+                table.for_each_dot([&keys](const std::string &name, const ValueData &) {
+                    keys.push_back(ValueData{ValueType::String, false, name});
+                });
+                return keys;
+            }),
+            Function("values", [](const TableData &table) {
+                std::vector<ValueData> values;
+                values.reserve(table.length());
+                table.for_each_index([&values](const ValueData &, const ValueData &value) {
+                    values.push_back(value);
+                });
+                table.for_each_dot([&values](const std::string &, const ValueData &member) {
+                    values.push_back(member);
+                });
+                return values;
+            }),
+            Function("size", [](const TableData &table) {
+                return static_cast<long long>(table.length());
+            }),
+            Function("push", [](TableData &table, const ValueData &value) {
+                // 追加到数组部分末尾（下标为当前长度）
+                long long length = static_cast<long long>(table.array_size());
+                table.index(ValueData{ValueType::Integer, false, length}) = value;
+                return length + 1;
+            }),
+            // 冻结的表：内容在副本之间共享，传参和赋值只复制指针；原地修改时自动解冻
+            Function("freeze", [](const TableData &table) {
+                TableData frozen = table;
+                frozen.freeze();
+                return ValueData{ValueType::Table, false, std::move(frozen)};
+            }),
+            Function("frozen", [](const TableData &table) {
+                return table.frozen();
+            }),
+            // 更新或删除一个键，返回新的冻结表，原表不变（只复制被修改的路径）
+            Function("with", [](const TableData &table, const ValueData &key, const ValueData &value) {
+                return ValueData{ValueType::Table, false, table.with(key, value)};
+            }),
+            Function("without", [](const TableData &table, const ValueData &key) {
+                return ValueData{ValueType::Table, false, table.without(key)};
+            })
+        );
+    }
+
+    // 文件输入输出模块
+    static IdentifierData IoModule() {
+        return Namespace("io",
+            Function("read_file", [](const std::string &filename) {
+                std::ifstream file(filename, std::ios::binary | std::ios::ate);
+                if (!file.is_open()) {
+                    throw std::runtime_error("[squaker.io] Failed to open file: " + filename);
+                }
+                // 按文件大小一次读入，省去stringstream的中间拷贝
+                std::string content(static_cast<size_t>(file.tellg()), '\0');
+                file.seekg(0);
+                file.read(content.data(), static_cast<std::streamsize>(content.size()));
+                return content;
+            }),
+            Native("open", [](std::vector<ValueData> &args, VM &) {
+                // io.open(path[, mode[, buffer]])，mode默认为"r"，buffer为缓冲块字节数
+                if (args.empty() || args.size() > 3) {
+                    throw std::runtime_error("[squaker.io] open expects 1 to 3 arguments");
+                }
+                std::string path = internal::TypeConverter<std::string>::convert(args[0]);
+                std::string mode = args.size() > 1 ? internal::TypeConverter<std::string>::convert(args[1]) : "r";
+                long long buffer = args.size() > 2 ? internal::TypeConverter<long long>::convert(args[2])
+                                                   : static_cast<long long>(FileHandle::kDefaultBuffer);
+                if (buffer <= 0) {
+                    throw std::runtime_error("[squaker.io] Buffer size must be positive");
+                }
+                return ValueData{ValueType::Object, false,
+                                 std::shared_ptr<ObjectData>(
+                                     std::make_shared<FileHandle>(path, mode, static_cast<size_t>(buffer)))};
+            }),
+            Function("map_file", [](const std::string &filename) {
+                // 只读映射：返回字节视图，切片、查找和逐行迭代都不拷贝内容
+                auto file = std::make_shared<MappedFile>(filename);
+                std::string_view content(file->data(), file->size());
+                return ValueData{ValueType::Object, false,
+                                 std::shared_ptr<ObjectData>(std::make_shared<ByteView>(std::move(file), content))};
+            }),
+            Function("write_file", [](const std::string &filename, const std::string &content) {
+                std::ofstream file(filename);
+                if (!file.is_open()) {
+                    throw std::runtime_error("[squaker.io] Failed to open file for writing: " + filename);
+                }
+                file << content;
+            })
+        );
+    }
+
+    // 操作系统工具模块
+    static IdentifierData OsModule() {
+        return Namespace("os",
+            Function("system", [](const std::string &command) {
+                int result = std::system(command.c_str());
+                return result;
+            }),
+            Function("getenv", [](const std::string &name) {
+                const char *value = std::getenv(name.c_str());
+                return value ? std::string(value) : "";
+            }),
+            Native("exit", [](std::vector<ValueData> &args, VM &vm) -> ValueData {
+                if (args.size() != 1) {
+                    throw std::runtime_error("[squaker.os] exit expects 1 argument");
+                }
+                int code = static_cast<int>(internal::TypeConverter<long long>::convert(args[0]));
+                vm.out.flush(); // 缓冲区中的输出先写出，std::exit 不会再回到脚本
+                std::exit(code);
+            }),
+            Function("sleep", [](long long seconds) {
+                std::this_thread::sleep_for(std::chrono::seconds(static_cast<int>(seconds)));
+            }),
+            Function("clock", []() {
+                return static_cast<long long>(std::clock() / CLOCKS_PER_SEC);
+            }),
+            Function("remove" , [](const std::string &filename) {
+                if (std::remove(filename.c_str()) != 0) {
+                    throw std::runtime_error("[squaker.os] Failed to remove file: " + filename);
+                }
+            }),
+            Function("date", []() {
+                std::time_t now = std::time(nullptr);
+                char buffer[100];
+                std::strftime(buffer, sizeof(buffer), "%Y-%m-%d %H:%M:%S", std::localtime(&now));
+                return std::string(buffer);
+            }),
+            Function("time", []() {
+                std::time_t now = std::time(nullptr);
+                return static_cast<long long>(now);
+            }),
+            Function("getpid", []() {
+                return static_cast<long long>(getpid());
+            }),
+            Function("rename", [](const std::string &old_name, const std::string &new_name) {
+                if (std::rename(old_name.c_str(), new_name.c_str()) != 0) {
+                    throw std::runtime_error("[squaker.os] Failed to rename file: " + old_name + " to " + new_name);
+                }
+            })
+        );
+    }
+
+    // 事件循环模块
+    static IdentifierData EventModule() {
+        return Namespace("event",
+            Function("timer", [](long long ms, ValueData callback) {
+                return EventLoop::current().add_timer(ms, 0, std::move(callback));
+            }),
+            Function("interval", [](long long ms, ValueData callback) {
+                if (ms <= 0) {
+                    throw std::runtime_error("[squaker.event] Interval must be positive");
+                }
+                return EventLoop::current().add_timer(ms, ms, std::move(callback));
+            }),
+            Function("go", [](ValueData generator) {
+                return EventLoop::current().add_coroutine(std::move(generator));
+            }),
+            Function("cancel", [](long long id) {
+                return EventLoop::current().cancel(id);
+            }),
+            Function("watch", [](long long fd, ValueData callback) {
+                EventLoop::current().watch(static_cast<int>(fd), std::move(callback));
+            }),
+            Function("write", [](long long fd, const std::string &data) {
+                EventLoop::current().write(static_cast<int>(fd), data);
+            }),
+            Function("close", [](long long fd) {
+                EventLoop::current().close(static_cast<int>(fd));
+            }),
+            Function("pipe", []() {
+                auto [readFd, writeFd] = EventLoop::current().pipe();
+                TableData ends;
+                ends.dot("read") = ValueData{ValueType::Integer, false, static_cast<long long>(readFd)};
+                ends.dot("write") = ValueData{ValueType::Integer, false, static_cast<long long>(writeFd)};
+                return ValueData{ValueType::Table, false, ends};
+            }),
+            Function("popen", [](const std::string &command, ValueData onData, ValueData onExit) {
+                return EventLoop::current().popen(command, std::move(onData), std::move(onExit));
+            }),
+            Function("read_file", [](const std::string &path, ValueData callback) {
+                EventLoop::current().read_file(path, std::move(callback));
+            }),
+            Function("write_file", [](const std::string &path, const std::string &content, ValueData callback) {
+                EventLoop::current().write_file(path, content, std::move(callback));
+            }),
+            Native("run", [](std::vector<ValueData> &args, VM &vm) {
+                if (!args.empty()) {
+                    throw std::runtime_error("[squaker.event] run expects no arguments");
+                }
+                EventLoop::current().run(vm);
+                return ValueData{ValueType::Nil};
+            }),
+            Function("stop", []() {
+                EventLoop::current().stop();
+            }),
+            Function("now", []() {
+                return EventLoop::now();
+            })
+        );
+    }
+
+    // 类型化数组模块
+    static IdentifierData ArrayModule() {
+        return Namespace("array",
+            Function("float64", [](ValueData source) {
+                // 整数n表示n个0，否则逐元素转换
+                if (source.type == ValueType::Integer) {
+                    long long n = std::get<long long>(source.value);
+                    if (n < 0) {
+                        throw std::runtime_error("[squaker.array] Length must not be negative");
                     }
-                }),
-                Function("date", []() {
-                    std::time_t now = std::time(nullptr);
-                    char buffer[100];
-                    std::strftime(buffer, sizeof(buffer), "%Y-%m-%d %H:%M:%S", std::localtime(&now));
-                    return std::string(buffer);
-                }),
-                Function("time", []() {
-                    std::time_t now = std::time(nullptr);
-                    return static_cast<long long>(now);
-                }),
-                Function("getpid", []() {
-                    return static_cast<long long>(getpid());
-                }),
-                Function("rename", [](const std::string &old_name, const std::string &new_name) {
-                    if (std::rename(old_name.c_str(), new_name.c_str()) != 0) {
-                        throw std::runtime_error("[squaker.os] Failed to rename file: " + old_name + " to " + new_name);
+                    return std::vector<double>(static_cast<size_t>(n));
+                }
+                return ToTypedVector<double>(source);
+            }),
+            Function("int64", [](ValueData source) {
+                if (source.type == ValueType::Integer) {
+                    long long n = std::get<long long>(source.value);
+                    if (n < 0) {
+                        throw std::runtime_error("[squaker.array] Length must not be negative");
                     }
-                })
-            );
+                    return std::vector<long long>(static_cast<size_t>(n));
+                }
+                return ToTypedVector<long long>(source);
+            }),
+            Function("records", [](const ValueData &type, long long n) {
+                // 记录类型的数组：按字段分列存放，n条字段均为Nil的记录
+                const TableShape *shape = AsRecord(type);
+                if (!shape) {
+                    throw std::runtime_error("[squaker.array] Expected a record type, got " + type.string());
+                }
+                if (n < 0) {
+                    throw std::runtime_error("[squaker.array] Length must not be negative");
+                }
+                return ValueData{ValueType::Object, false,
+                                 std::shared_ptr<ObjectData>(std::make_shared<RecordArray>(*shape, static_cast<size_t>(n)))};
+            }),
+            Function("range", [](long long start, long long end) {
+                // [start, end) 的整数序列
+                std::vector<long long> values;
+                if (end > start) {
+                    values.reserve(static_cast<size_t>(end - start));
+                    for (long long i = start; i < end; ++i)
+                        values.push_back(i);
+                }
+                return values;
+            })
+        );
+    }
+
+    // 脚本模块：解析并执行一次，顶层变量组成模块的命名空间
+    struct ScriptModule {
+        std::filesystem::file_time_type mtime; // 加载时文件的修改时间
+        std::unique_ptr<ExprNode> code;         // 解析好的语法树
+        std::unique_ptr<const ValueData> value; // 模块的命名空间
+    };
+
+    // 模块注册表：工厂在第一次导入时调用，构建好的模块在进程内只读共享
+    // （工厂和脚本模块中可以再导入其他模块，因此使用可重入锁）
+    struct ModuleRegistry {
+        std::recursive_mutex mutex;
+        std::unordered_map<std::string, ModuleFactory> factories;
+        std::unordered_map<std::string, std::unique_ptr<const ValueData>> modules;
+        std::vector<std::string> paths; // 原生模块与脚本模块的查找目录
+        std::unordered_map<std::string, ScriptModule> scripts; // 脚本模块（按规范路径）
+        std::vector<ScriptModule> retired; // 文件修改后被替换的旧版本（解析期绑定的成员仍指向它们）
+        std::unordered_set<std::string> loading; // 正在加载的脚本模块（检测循环导入）
+
+        ModuleRegistry() {
+            factories = {
+                {"math", MathModule},   {"string", StringModule}, {"table", TableModule}, {"io", IoModule},
+                {"os", OsModule},       {"event", EventModule},   {"array", ArrayModule},
+            };
+#ifdef _WIN32
+            const char separator = ';';
+#else
+            const char separator = ':';
+#endif
+            if (const char *env = std::getenv("SQUAKER_MODULE_PATH")) {
+                std::stringstream list(env);
+                std::string directory;
+                while (std::getline(list, directory, separator)) {
+                    if (!directory.empty())
+                        paths.push_back(directory);
+                }
+            }
+        }
+    };
+
+    static ModuleRegistry &Modules() {
+        static ModuleRegistry registry;
+        return registry;
+    }
+
+    // 注册模块
+    void RegisterModule(const std::string &module_name, ModuleFactory factory) {
+        ModuleRegistry &registry = Modules();
+        std::lock_guard<std::recursive_mutex> lock(registry.mutex);
+        if (registry.factories.count(module_name)) {
+            throw std::runtime_error("[squaker.module] Module already registered: " + module_name);
+        }
+        registry.factories.emplace(module_name, std::move(factory));
+    }
+
+    // 添加原生模块的查找目录
+    void AddModulePath(const std::string &directory) {
+        ModuleRegistry &registry = Modules();
+        std::lock_guard<std::recursive_mutex> lock(registry.mutex);
+        registry.paths.push_back(directory);
+    }
+
+    // 从共享库加载原生模块（库在进程结束前不会卸载，模块中的函数一直有效）
+    void LoadNativeModule(const std::string &module_name, const std::string &library_path) {
+        using AbiFunction = int (*)();
+        using InitFunction = void (*)(IdentifierData *);
+#ifdef _WIN32
+        HMODULE library = LoadLibraryA(library_path.c_str());
+        if (!library) {
+            throw std::runtime_error("[squaker.module] Cannot load native module: " + library_path);
+        }
+        auto abi = reinterpret_cast<AbiFunction>(GetProcAddress(library, "squaker_module_abi"));
+        auto init = reinterpret_cast<InitFunction>(GetProcAddress(library, "squaker_module_init"));
+#else
+        void *library = dlopen(library_path.c_str(), RTLD_NOW | RTLD_LOCAL);
+        if (!library) {
+            throw std::runtime_error("[squaker.module] Cannot load native module: " + std::string(dlerror()));
+        }
+        auto abi = reinterpret_cast<AbiFunction>(dlsym(library, "squaker_module_abi"));
+        auto init = reinterpret_cast<InitFunction>(dlsym(library, "squaker_module_init"));
+#endif
+        if (!abi || !init) {
+            throw std::runtime_error("[squaker.module] Missing squaker_module_abi/squaker_module_init in " +
+                                     library_path);
+        }
+        if (abi() != SQUAKER_MODULE_ABI) {
+            throw std::runtime_error("[squaker.module] Native module " + library_path + " was built for ABI " +
+                                     std::to_string(abi()) + ", expected " + std::to_string(SQUAKER_MODULE_ABI));
+        }
+        RegisterModule(module_name, [init]() {
+            IdentifierData module;
+            init(&module);
+            return module;
+        });
+    }
+
+    // 在查找目录中寻找原生模块的共享库
+    static bool FindNativeModule(ModuleRegistry &registry, const std::string &module_name) {
+#if defined(_WIN32)
+        const std::string suffix = ".dll";
+#elif defined(__APPLE__)
+        const std::string suffix = ".dylib";
+#else
+        const std::string suffix = ".so";
+#endif
+        for (const auto &directory : registry.paths) {
+            std::string path = directory + "/" + module_name + suffix;
+            if (std::ifstream(path).good()) {
+                LoadNativeModule(module_name, path);
+                return true;
+            }
         }
-        else {
-            throw std::runtime_error("[squaker.module] Unknown module: " + module_name);
+        return false;
+    }
+
+    // 是否为脚本模块（以.sq结尾的路径）
+    static bool IsScriptModule(const std::string &module_name) {
+        return module_name.size() > 3 && module_name.compare(module_name.size() - 3, 3, ".sq") == 0;
+    }
+
+    // 脚本模块的文件：相对路径先相对导入它的脚本所在的目录（为空时是当前工作目录），再依次在查找目录中寻找
+    static std::filesystem::path FindScriptModule(const ModuleRegistry &registry, const std::string &module_name,
+                                                  const std::string &directory) {
+        std::error_code error;
+        std::filesystem::path name(module_name);
+        std::vector<std::filesystem::path> candidates{directory.empty() || name.is_absolute()
+                                                          ? name
+                                                          : std::filesystem::path(directory) / name};
+        if (name.is_relative()) {
+            for (const auto &path : registry.paths)
+                candidates.push_back(std::filesystem::path(path) / name);
         }
+        for (const auto &candidate : candidates) {
+            std::filesystem::path path = std::filesystem::canonical(candidate, error);
+            if (!error && std::filesystem::is_regular_file(path, error))
+                return path;
+        }
+        throw std::runtime_error("[squaker.module] Cannot find module file: " + module_name);
+    }
 
+    // 加载脚本模块：同一文件只解析、执行一次，修改时间变化后重新加载
+    static const ValueData &LoadScriptModule(ModuleRegistry &registry, const std::string &module_name,
+                                             const std::string &directory) {
+        std::error_code error;
+        std::filesystem::path path = FindScriptModule(registry, module_name, directory);
+        std::string key = path.string();
+        auto mtime = std::filesystem::last_write_time(path, error);
+        auto cached = registry.scripts.find(key);
+        if (cached != registry.scripts.end()) {
+            if (cached->second.mtime == mtime) {
+                return *cached->second.value;
+            }
+            registry.retired.push_back(std::move(cached->second));
+            registry.scripts.erase(cached);
+        }
+        if (!registry.loading.insert(key).second) {
+            throw std::runtime_error("[squaker.module] Circular import of module: " + module_name);
+        }
+        struct LoadingGuard {
+            std::unordered_set<std::string> &loading;
+            const std::string &key;
+            ~LoadingGuard() {
+                loading.erase(key);
+            }
+        } guard{registry.loading, key};
+
+        ScriptModule module;
+        module.mtime = mtime;
+        TableData members;
+        try {
+            // 在独立的解析器和虚拟机中执行模块代码（模块中的相对导入相对模块文件所在的目录）
+            Parser parser(ParseTokens(ReadFile(key)));
+            parser.directory = path.parent_path().string();
+            module.code = parser.parse();
+            VM vm;
+            vm.enter(parser.curScope->size());
+            module.code->execute(vm); // 模块代码的值不会被使用
+            vm.out.flush();
+            // 顶层变量成为模块成员
+            for (const auto &[name, slot] : parser.curScope->bindings()) {
+                const ValueData &value = vm.local(slot);
+                if (value.type != ValueType::Nil)
+                    members.emplace_dot(name, value);
+            }
+        } catch (const std::exception &e) {
+            throw std::runtime_error("[squaker.module] Error in module " + module_name + ": " + e.what());
+        }
+        module.value = std::make_unique<const ValueData>(ValueData{ValueType::Table, true, std::move(members)});
+        return *registry.scripts.emplace(key, std::move(module)).first->second.value;
+    }
+
+    // 模块在脚本中绑定的名字：脚本模块取文件名（不含扩展名），其余模块就是模块名
+    std::string ModuleBindingName(const std::string &module_name) {
+        if (!IsScriptModule(module_name)) {
+            return module_name;
+        }
+        std::string name = std::filesystem::path(module_name).stem().string();
+        // 文件名必须是合法的标识符，否则绑定后无法在脚本中引用
+        bool valid = !name.empty() && (std::isalpha(static_cast<unsigned char>(name[0])) || name[0] == '_');
+        for (char c : name)
+            valid = valid && (std::isalnum(static_cast<unsigned char>(c)) || c == '_');
+        if (!valid) {
+            throw std::runtime_error("[squaker.module] Module file name is not a valid identifier: " + name +
+                                     " (use import \"" + module_name + "\" as name)");
+        }
+        return name;
+    }
+
+    // 进程内共享的模块：首次导入时构建，之后所有脚本只读共享同一份
+    const ValueData &LoadModule(const std::string &module_name, const std::string &directory) {
+        ModuleRegistry &registry = Modules();
+        std::lock_guard<std::recursive_mutex> lock(registry.mutex);
+        if (IsScriptModule(module_name)) {
+            return LoadScriptModule(registry, module_name, directory);
+        }
+        auto it = registry.modules.find(module_name);
+        if (it != registry.modules.end()) {
+            return *it->second;
+        }
+        auto factory = registry.factories.find(module_name);
+        if (factory == registry.factories.end()) {
+            if (!FindNativeModule(registry, module_name)) {
+                throw std::runtime_error("[squaker.module] Unknown module: " + module_name);
+            }
+            factory = registry.factories.find(module_name);
+        }
+        ValueData module = factory->second().value;
+        if (module.type != ValueType::Table) {
+            throw std::runtime_error("[squaker.module] Module factory must return a namespace: " + module_name);
+        }
+        module.is_const = true;
+        it = registry.modules.emplace(module_name, std::make_unique<const ValueData>(std::move(module))).first;
+        return *it->second;
+    }
+
+    IdentifierData Module(std::string module_name) {
+        return {module_name, LoadModule(module_name)};
     }
 
-} // namespace squ
+} // namespace squ
\ No newline at end of file
@@ -1,9 +1,17 @@
 #include "../include/node.h"
+#include "../include/control.h"
+#include "../include/generator.h"
+#include "../include/identifier.h"
+#include "../include/intrinsic.h"
+#include "../include/mapped.h"
 #include "../include/operator.h"
+#include "../include/task.h"
 #include "../include/type.h"
 #include "../include/vm.h"
+#include <algorithm>
 #include <cmath>
 #include <iostream>
+#include <iterator>
 #include <map>
 #include <memory>
 #include <stdexcept>
@@ -11,33 +19,193 @@
 
 namespace squ {
 
-    // 控制流异常类
-    class BreakException : public std::exception {
-      public:
-        BreakException() : std::exception() {}
-    };
+    // 在可恢复位置上求值子节点：生成器挂起时记录该位置，恢复时据此跳回
+    static ValueData evaluate_at(const ExprNode &node, VM &vm, Coroutine *co, size_t point) {
+        try {
+            return node.evaluate(vm);
+        } catch (const YieldException &) {
+            if (co)
+                co->path.push_back(point);
+            throw;
+        }
+    }
+
+    // 同上，以语句方式执行（丢弃结果）
+    static void execute_at(const ExprNode &node, VM &vm, Coroutine *co, size_t point) {
+        try {
+            node.execute(vm);
+        } catch (const YieldException &) {
+            if (co)
+                co->path.push_back(point);
+            throw;
+        }
+    }
+
+    // 同上，作为条件求值
+    static bool condition_at(const ExprNode &node, VM &vm, Coroutine *co, size_t point) {
+        try {
+            return node.evaluate_condition(vm);
+        } catch (const YieldException &) {
+            if (co)
+                co->path.push_back(point);
+            throw;
+        }
+    }
+
+    // 默认的条件求值：求值后判断真假
+    bool ExprNode::evaluate_condition(VM &vm) const {
+        return IsTruthy(evaluate(vm));
+    }
+
+    // 默认的只读求值：求值结果存入scratch
+    const ValueData &ExprNode::evaluate_ref(VM &vm, ValueData &scratch) const {
+        scratch = evaluate(vm);
+        return scratch;
+    }
 
-    class ContinueException : public std::exception {
-      public:
-        ContinueException() : std::exception() {}
-    };
+    // 在可恢复位置上只读求值子节点
+    static const ValueData &evaluate_ref_at(const ExprNode &node, VM &vm, Coroutine *co, size_t point,
+                                            ValueData &scratch) {
+        try {
+            return node.evaluate_ref(vm, scratch);
+        } catch (const YieldException &) {
+            if (co)
+                co->path.push_back(point);
+            throw;
+        }
+    }
+
+    // 只读求值的结果转成独立的值：结果就在scratch中时直接移出，否则只拷贝这一个值
+    static ValueData take_ref(const ValueData &result, ValueData &scratch) {
+        if (&result == &scratch)
+            return std::move(scratch);
+        return result;
+    }
+
+    // 只读路径：变量、字面量、模块成员以及由它们组成的成员访问和索引，求值没有副作用，
+    // 不会修改任何已有的值，因此先前借用的引用在它求值之后仍然有效
+    static bool is_path(const ExprNode &node) {
+        switch (node.type()) {
+            case NodeType::Identifier:
+            case NodeType::ModuleMember:
+                return true;
+            case NodeType::Literal:
+                return dynamic_cast<const LiteralNode *>(&node) != nullptr; // 常量节点也报告为Literal
+            case NodeType::MemberAccess:
+                return is_path(static_cast<const MemberAccessNode &>(node).target());
+            case NodeType::Index: {
+                const auto &index = static_cast<const IndexNode &>(node);
+                return is_path(index.target()) && is_path(index.key());
+            }
+            default:
+                return false;
+        }
+    }
 
-    class ReturnException : public std::exception {
-      public:
-        ValueData value; // 返回值
-        explicit ReturnException(ValueData val) : value(std::move(val)) {}
-    };
+    // 实参中只读路径的位掩码
+    static uint64_t path_mask(const std::vector<std::unique_ptr<ExprNode>> &arguments) {
+        uint64_t mask = 0;
+        for (size_t i = 0; i < arguments.size() && i < 64; i++) {
+            if (is_path(*arguments[i]))
+                mask |= uint64_t{1} << i;
+        }
+        return mask;
+    }
+
+    // 调用原生函数：实参以指针数组交给调用桩，能借用的实参不拷贝。
+    // 没有可写引用参数时，只读路径的实参直接借用其值（变量、表成员、数组元素本身）；
+    // 有可写引用参数时只借用变量（可写参数指向变量本身，同一变量出现两次时后面的按值传递），
+    // 避免被修改的容器里的元素同时被借用。其余实参先求值到临时值中，之后才借用，
+    // 借用的引用在调用前不会因为其他实参的求值而失效
+    static ValueData call_native(const NativeFunction &native, const std::vector<std::unique_ptr<ExprNode>> &arguments,
+                                 uint64_t pathArgs, VM &vm) {
+        constexpr size_t kInline = NativeFunction::kInlineArgs;
+        size_t count = arguments.size();
+        ValueData inlineValues[kInline];
+        ValueData *inlinePointers[kInline];
+        std::vector<ValueData> heapValues;
+        std::vector<ValueData *> heapPointers;
+        ValueData *values = inlineValues;
+        ValueData **pointers = inlinePointers;
+        if (count > kInline) {
+            heapValues.resize(count);
+            heapPointers.resize(count);
+            values = heapValues.data();
+            pointers = heapPointers.data();
+        }
+
+        auto borrowable = [&](size_t i) {
+            if (i >= 64)
+                return false;
+            if (native.refParams != 0)
+                return arguments[i]->type() == NodeType::Identifier;
+            return (pathArgs >> i & 1) != 0;
+        };
+        for (size_t i = 0; i < count; i++) {
+            if (!borrowable(i)) {
+                values[i] = arguments[i]->evaluate(vm);
+                pointers[i] = &values[i];
+            }
+        }
+        for (size_t i = 0; i < count; i++) {
+            if (!borrowable(i))
+                continue;
+            ValueData *place;
+            if (native.refParams >> i & 1) {
+                place = &arguments[i]->evaluate_lvalue(vm); // 可写引用参数指向变量本身
+            } else {
+                const ValueData &value = arguments[i]->evaluate_ref(vm, values[i]);
+                place = const_cast<ValueData *>(&value); // 只读参数的转换不修改实参
+                if ((native.ownedParams >> i & 1) && value.type != ValueType::String) {
+                    if (place != &values[i])
+                        values[i] = value; // 转换时会改写实参，交给调用桩一份副本
+                    place = &values[i];
+                }
+            }
+            if (native.refParams != 0 && std::find(pointers, pointers + i, place) != pointers + i) {
+                values[i] = *place; // 同一个变量传了两次，后面的按值传递
+                place = &values[i];
+            }
+            pointers[i] = place;
+        }
+        return native.call(pointers, vm);
+    }
+
+    // 取回恢复位置；不在恢复过程中时返回起始位置
+    static size_t resume_from(Coroutine *co, size_t start) {
+        if (co && co->resuming && !co->path.empty())
+            return co->resume_point();
+        return start;
+    }
+
+    // 读-改-写的目标位置：左值只解析一次（下标、成员查找各做一次），随后直接在该位置上修改
+    static Place resolve_place(const ExprNode &node, VM &vm, const char *module) {
+        Place place;
+        if (node.type() == NodeType::Index) {
+            place = static_cast<const IndexNode &>(node).place(vm);
+        } else {
+            place.ref = &node.evaluate_lvalue(vm);
+        }
+        if (place.get().is_const) {
+            throw std::runtime_error(std::string("[squaker.") + module + "] Cannot assign to const variable");
+        }
+        return place;
+    }
 
     // 统一字面量节点
     std::string LiteralNode::string() const {
         return data.string();
     }
 
-    ValueData LiteralNode::evaluate(VM &vm) const {
+    ValueData LiteralNode::evaluate(VM &) const {
+        return data;
+    }
+
+    const ValueData &LiteralNode::evaluate_ref(VM &, ValueData &) const {
         return data;
     }
 
-    ValueData &LiteralNode::evaluate_lvalue(VM &vm) const {
+    ValueData &LiteralNode::evaluate_lvalue(VM &) const {
         // 字面量节点通常不支持左值求值
         throw std::runtime_error("[squaker.literal] Literal nodes cannot be evaluated as lvalues");
     }
@@ -46,6 +214,10 @@ namespace squ {
         return std::make_unique<LiteralNode>(data);
     }
 
+    bool LiteralNode::evaluate_condition(VM &) const {
+        return IsTruthy(data);
+    }
+
     // 标识符节点
     std::string IdentifierNode::string() const {
         return "v" + std::to_string(index);
@@ -63,6 +235,14 @@ namespace squ {
         return vm.local(index);
     }
 
+    const ValueData &IdentifierNode::evaluate_ref(VM &vm, ValueData &) const {
+        const ValueData &data = vm.local(index);
+        if (data.type == ValueType::Nil) {
+            throw std::runtime_error("[squaker.identifier] Undefined identifier: " + name);
+        }
+        return data;
+    }
+
     std::unique_ptr<ExprNode> IdentifierNode::clone() const {
         return std::make_unique<IdentifierNode>(name, index);
     }
@@ -77,10 +257,13 @@ namespace squ {
     ValueData ConstantNode::evaluate(VM &vm) const {
         ValueData data = expr->evaluate(vm);
         data.is_const = true;
+        // 常量表转为冻结表示，之后的拷贝（传参、赋值）只复制指针
+        if (data.type == ValueType::Table)
+            std::get<TableData>(data.value).freeze();
         return data;
     }
 
-    ValueData &ConstantNode::evaluate_lvalue(VM &vm) const {
+    ValueData &ConstantNode::evaluate_lvalue(VM &) const {
         // 常量节点通常不支持左值求值
         throw std::runtime_error("[squaker.constant] Constant nodes cannot be evaluated as lvalues");
     }
@@ -91,13 +274,33 @@ namespace squ {
 
     // 二元操作节点
     BinaryOpNode::BinaryOpNode(std::string op, std::unique_ptr<ExprNode> l, std::unique_ptr<ExprNode> r)
-        : op(std::move(op)), left(std::move(l)), right(std::move(r)) {}
+        : op(std::move(op)), left(std::move(l)), right(std::move(r)) {
+        comparison = ParseCompareOp(this->op, compareOp);
+    }
 
     std::string BinaryOpNode::string() const {
         return "(" + left->string() + " " + op + " " + right->string() + ")";
     }
 
     ValueData BinaryOpNode::evaluate(VM &vm) const {
+        // 连续拼接：依次求值后一次拼成结果，不产生中间字符串
+        std::vector<const ExprNode *> parts;
+        if (concat_operands(parts)) {
+            std::vector<ValueData> values;
+            values.reserve(parts.size());
+            size_t total = 0;
+            for (const ExprNode *part : parts) {
+                values.push_back(part->evaluate(vm));
+                if (values.back().type == ValueType::String)
+                    total += std::get<StringData>(values.back().value).size();
+            }
+            std::string text;
+            text.reserve(total);
+            for (const auto &value : values)
+                AppendConcat(text, value);
+            return ValueData{ValueType::String, false, std::move(text)};
+        }
+
         // 计算左值和右值
         ValueData leftVal = left->evaluate(vm);
         ValueData rightVal = right->evaluate(vm);
@@ -106,7 +309,7 @@ namespace squ {
         return ApplyBinary(leftVal, op, rightVal);
     }
 
-    ValueData &BinaryOpNode::evaluate_lvalue(VM &vm) const {
+    ValueData &BinaryOpNode::evaluate_lvalue(VM &) const {
         // 二元操作通常不支持左值求值
         throw std::runtime_error("[squaker.binary] Binary operations cannot be evaluated as lvalues");
     }
@@ -115,6 +318,66 @@ namespace squ {
         return std::make_unique<BinaryOpNode>(op, left->clone(), right->clone());
     }
 
+    bool BinaryOpNode::evaluate_condition(VM &vm) const {
+        if (!comparison) {
+            return IsTruthy(evaluate(vm));
+        }
+        // 比较操作直接得到bool
+        ValueData leftVal = left->evaluate(vm);
+        ValueData rightVal = right->evaluate(vm);
+        return ApplyCompare(leftVal, compareOp, rightVal);
+    }
+
+    // 逻辑节点
+    LogicalNode::LogicalNode(const std::string &op, std::unique_ptr<ExprNode> l, std::unique_ptr<ExprNode> r)
+        : isAnd(op == "&&"), left(std::move(l)), right(std::move(r)) {}
+
+    std::string LogicalNode::string() const {
+        return "(" + left->string() + (isAnd ? " && " : " || ") + right->string() + ")";
+    }
+
+    ValueData LogicalNode::evaluate(VM &vm) const {
+        return ValueData{ValueType::Bool, false, evaluate_condition(vm)};
+    }
+
+    bool LogicalNode::evaluate_condition(VM &vm) const {
+        // 恢复位置：0为左操作数，1为右操作数
+        Coroutine *co = vm.coroutine();
+        size_t point = resume_from(co, 0);
+        if (point == 0) {
+            bool leftVal = condition_at(*left, vm, co, 0);
+            if (leftVal != isAnd) {
+                return leftVal; // && 左边为假、|| 左边为真时结果已确定
+            }
+        }
+        return condition_at(*right, vm, co, 1);
+    }
+
+    ValueData &LogicalNode::evaluate_lvalue(VM &) const {
+        throw std::runtime_error("[squaker.logical] Logical operations cannot be evaluated as lvalues");
+    }
+
+    std::unique_ptr<ExprNode> LogicalNode::clone() const {
+        return std::make_unique<LogicalNode>(isAnd ? "&&" : "||", left->clone(), right->clone());
+    }
+
+    // 展开左结合的拼接链 ((a .. b) .. c)
+    bool BinaryOpNode::concat_operands(std::vector<const ExprNode *> &parts) const {
+        if (op != "..")
+            return false;
+        std::vector<const ExprNode *> rights;
+        const ExprNode *node = this;
+        while (auto *binary = dynamic_cast<const BinaryOpNode *>(node)) {
+            if (binary->op != "..")
+                break;
+            rights.push_back(binary->right.get());
+            node = binary->left.get();
+        }
+        parts.push_back(node);
+        parts.insert(parts.end(), rights.rbegin(), rights.rend());
+        return true;
+    }
+
     // 一元操作节点（前缀）
     UnaryOpNode::UnaryOpNode(std::string op, std::unique_ptr<ExprNode> expr)
         : op(std::move(op)), operand(std::move(expr)) {}
@@ -124,14 +387,37 @@ namespace squ {
     }
 
     ValueData UnaryOpNode::evaluate(VM &vm) const {
-        ValueData operandVal = operand->evaluate(vm);
-        ValueData &operandRef = operand->evaluate_lvalue(vm);
+        // 前缀自增/减：原地修改后返回新值
+        if (op == "++" || op == "--") {
+            Place place = resolve_place(*operand, vm, "unary");
+            ApplyIncrement(place.get(), op == "++" ? 1 : -1);
+            place.commit();
+            return place.get();
+        }
+        // 逻辑非按条件求值，操作数不必先构造成值
+        if (op == "!") {
+            return ValueData{ValueType::Bool, false, !operand->evaluate_condition(vm)};
+        }
+        return ApplyUnary(op, operand->evaluate(vm));
+    }
+
+    void UnaryOpNode::execute(VM &vm) const {
+        if (op == "++" || op == "--") {
+            Place place = resolve_place(*operand, vm, "unary");
+            ApplyIncrement(place.get(), op == "++" ? 1 : -1);
+            place.commit();
+            return;
+        }
+        evaluate(vm);
+    }
 
-        // 应用一元操作
-        return ApplyUnary(op, operandVal);
+    bool UnaryOpNode::evaluate_condition(VM &vm) const {
+        if (op == "!")
+            return !operand->evaluate_condition(vm);
+        return IsTruthy(evaluate(vm));
     }
 
-    ValueData &UnaryOpNode::evaluate_lvalue(VM &vm) const {
+    ValueData &UnaryOpNode::evaluate_lvalue(VM &) const {
         // 一元操作通常不支持左值求值
         throw std::runtime_error("[squaker.unary] Unary operations cannot be evaluated as lvalues");
     }
@@ -149,42 +435,22 @@ namespace squ {
     }
 
     ValueData PostfixOpNode::evaluate(VM &vm) const {
-        ValueData operandVal = operand->evaluate(vm);
-        if (operandVal.is_const == true) {
-            throw std::runtime_error("[squaker.postfix] Cannot apply postfix operator to const");
-        }
-        ValueData &operandRef = operand->evaluate_lvalue(vm);
-        if (op == "++") {
-            if (operandVal.type == ValueType::Integer) {
-                long long &val = std::get<long long>(operandRef.value);
-                val++;
-                operandRef = ValueData{ValueType::Integer, false, val};
-                return ValueData{ValueType::Integer, false, val};
-            } else if (operandVal.type == ValueType::Real) {
-                double &val = std::get<double>(operandRef.value);
-                val++;
-                operandRef = ValueData{ValueType::Real, false, val};
-                return ValueData{ValueType::Real, false, val};
-            }
-            throw std::runtime_error("[squaker.postfix:'++'] unsupported type for postfix increment");
-        } else if (op == "--") {
-            if (operandVal.type == ValueType::Integer) {
-                long long &val = std::get<long long>(operandRef.value);
-                val--;
-                operandRef = ValueData{ValueType::Integer, false, val};
-                return ValueData{ValueType::Integer, false, val};
-            } else if (operandVal.type == ValueType::Real) {
-                double &val = std::get<double>(operandRef.value);
-                val--;
-                operandRef = ValueData{ValueType::Real, false, val};
-                return ValueData{ValueType::Real, false, val};
-            }
-            throw std::runtime_error("[squaker.postfix:'--'] unsupported type for postfix decrement");
-        }
-        throw std::runtime_error("[squaker.postfix] unknown postfix operator: " + op);
+        // 后缀自增/减：返回修改前的值
+        Place place = resolve_place(*operand, vm, "postfix");
+        ValueData old = place.get();
+        ApplyIncrement(place.get(), op == "++" ? 1 : -1);
+        place.commit();
+        return old;
+    }
+
+    void PostfixOpNode::execute(VM &vm) const {
+        // 语句中不需要旧值，直接原地修改
+        Place place = resolve_place(*operand, vm, "postfix");
+        ApplyIncrement(place.get(), op == "++" ? 1 : -1);
+        place.commit();
     }
 
-    ValueData &PostfixOpNode::evaluate_lvalue(VM &vm) const {
+    ValueData &PostfixOpNode::evaluate_lvalue(VM &) const {
         // 后缀操作通常不支持左值求值
         throw std::runtime_error("[squaker.postfix] Postfix operations cannot be evaluated as lvalues");
     }
@@ -195,27 +461,88 @@ namespace squ {
 
     // 赋值节点
     AssignmentNode::AssignmentNode(std::string op, std::unique_ptr<ExprNode> l, std::unique_ptr<ExprNode> r)
-        : op(std::move(op)), left(std::move(l)), right(std::move(r)) {}
+        : op(std::move(op)), left(std::move(l)), right(std::move(r)) {
+        // 识别 x = x .. a .. b（x为局部变量），执行时原地追加
+        std::vector<const ExprNode *> parts;
+        auto *concat = dynamic_cast<const BinaryOpNode *>(right.get());
+        if (left->type() == NodeType::Identifier && concat && concat->concat_operands(parts) &&
+            parts.front()->type() == NodeType::Identifier && parts.front()->string() == left->string()) {
+            appendParts.assign(parts.begin() + 1, parts.end());
+        }
+    }
 
     std::string AssignmentNode::string() const {
         return "(" + left->string() + " " + op + " " + right->string() + ")";
     }
 
     ValueData AssignmentNode::evaluate(VM &vm) const {
-        // 计算左值和右值
+        ValueData scratch;
+        return assign(vm, scratch); // 返回赋值后的左值
+    }
+
+    void AssignmentNode::execute(VM &vm) const {
+        ValueData scratch;
+        assign(vm, scratch); // 语句中不需要结果，省去一次拷贝
+    }
+
+    ValueData &AssignmentNode::assign(VM &vm, ValueData &scratch) const {
+        if (!appendParts.empty()) {
+            // 与普通拼接一样先读取x：未定义时报错，不会把nil拼进结果
+            left->evaluate_ref(vm, scratch);
+            // 先求值追加的部分，再追加到原字符串末尾（容量按倍数增长，重复拼接总体为线性时间）
+            std::vector<ValueData> values;
+            values.reserve(appendParts.size());
+            for (const ExprNode *part : appendParts)
+                values.push_back(part->evaluate(vm));
+            ValueData &target = left->evaluate_lvalue(vm);
+            if (target.is_const == true) {
+                throw std::runtime_error("[squaker.assignment] Cannot assign to const variable");
+            }
+            if (target.type == ValueType::String) {
+                std::string &text = std::get<StringData>(target.value).edit(); // 内容被共享时先复制
+                for (const auto &value : values)
+                    AppendConcat(text, value);
+                return target;
+            }
+            // 原值不是字符串时按普通拼接处理
+            std::string text;
+            AppendConcat(text, target);
+            for (const auto &value : values)
+                AppendConcat(text, value);
+            target = ValueData{ValueType::String, false, std::move(text)};
+            return target;
+        }
+
+        // 先求值右侧，再解析左值：表成员按槽位存放，右侧加入或删除成员会使先取得的位置失效
+        ValueData rightVal = right->evaluate(vm);
+        if (left->type() == NodeType::Index) {
+            // 下标赋值：对象的元素（如类型化数组）写入对象，其余与普通赋值相同
+            Place place = static_cast<const IndexNode &>(*left).place(vm);
+            if (place.object) {
+                place.value = std::move(rightVal);
+                place.commit();
+                scratch = std::move(place.value);
+                return scratch;
+            }
+            if (place.ref->is_const == true) {
+                throw std::runtime_error("[squaker.assignment] Cannot assign to const variable");
+            }
+            *place.ref = std::move(rightVal);
+            place.ref->is_const = false;
+            return *place.ref;
+        }
         ValueData &leftValRef = left->evaluate_lvalue(vm);
         if (leftValRef.is_const == true) {
             throw std::runtime_error("[squaker.assignment] Cannot assign to const variable");
         }
-        ValueData rightVal = right->evaluate(vm);
 
         // 应用二元操作
-        leftValRef = rightVal; // 简单赋值
+        leftValRef = std::move(rightVal); // 简单赋值
         leftValRef.is_const = false; // 确保左值不是常量
-        return leftValRef;     // 返回赋值后的左值
+        return leftValRef;
     }
 
-    ValueData &AssignmentNode::evaluate_lvalue(VM &vm) const {
+    ValueData &AssignmentNode::evaluate_lvalue(VM &) const {
         throw std::runtime_error("[squaker.assignment] Assignment nodes cannot be evaluated as lvalues");
     }
 
@@ -226,28 +553,37 @@ namespace squ {
     // 复合赋值节点（如 +=, -= 等）
     CompoundAssignmentNode::CompoundAssignmentNode(std::string op, std::unique_ptr<ExprNode> l,
                                                    std::unique_ptr<ExprNode> r)
-        : op(std::move(op)), left(std::move(l)), right(std::move(r)) {}
+        : op(std::move(op)), left(std::move(l)), right(std::move(r)) {
+        binaryOp = this->op.substr(0, this->op.size() - 1); // 去掉末尾的 =
+    }
 
     std::string CompoundAssignmentNode::string() const {
         return "(" + left->string() + " " + op + " " + right->string() + ")";
     }
 
     ValueData CompoundAssignmentNode::evaluate(VM &vm) const {
-        // 计算左值和右值
-        ValueData leftVal = left->evaluate(vm);
-        if (leftVal.is_const == true) {
-            throw std::runtime_error("[squaker.assignment] Cannot assign to const variable");
-        }
-        ValueData &leftValRef = left->evaluate_lvalue(vm);
-        ValueData rightVal = right->evaluate(vm);
+        ValueData scratch;
+        return assign(vm, scratch); // 返回赋值后的左值
+    }
 
-        // 应用二元操作
-        leftValRef = ApplyBinary(leftVal, op, rightVal);
-        leftValRef.is_const = false; // 确保左值不是常量
-        return leftValRef; // 返回赋值后的左值
+    void CompoundAssignmentNode::execute(VM &vm) const {
+        ValueData scratch;
+        assign(vm, scratch); // 语句中不需要结果，省去一次拷贝
+    }
+
+    ValueData &CompoundAssignmentNode::assign(VM &vm, ValueData &scratch) const {
+        // 先求值右侧，再解析左值：右侧的求值可能改动容器，解析出的位置在修改前保持有效
+        ValueData rightVal = right->evaluate(vm);
+        Place place = resolve_place(*left, vm, "assignment");
+        ApplyCompound(place.get(), binaryOp, rightVal);
+        if (!place.object)
+            return *place.ref;
+        place.commit();
+        scratch = std::move(place.value);
+        return scratch;
     }
 
-    ValueData &CompoundAssignmentNode::evaluate_lvalue(VM &vm) const {
+    ValueData &CompoundAssignmentNode::evaluate_lvalue(VM &) const {
         throw std::runtime_error(
             "[squaker.compound_assignment] Compound assignment nodes cannot be evaluated as lvalues");
     }
@@ -257,8 +593,9 @@ namespace squ {
     }
 
     // Lambda节点（函数定义）
-    LambdaNode::LambdaNode(std::vector<Parameter> params, std::unique_ptr<ExprNode> b)
-        : parameters(std::move(params)), body(std::move(b)) {}
+    LambdaNode::LambdaNode(std::vector<Parameter> params, std::unique_ptr<ExprNode> b, size_t slots, bool gen)
+        : parameters(std::move(params)), body(std::move(b)), maxSlot(std::max(slots, parameters.size())),
+          generator(gen) {}
 
     std::string LambdaNode::string() const {
         std::string params;
@@ -267,59 +604,84 @@ namespace squ {
                 params += ", ";
             params += "v" + std::to_string(parameters[i].slot);
         }
-        return "(function (" + params + ") -> " + body->string() + ")";
-    }
+        return std::string(generator ? "(generator (" : "(function (") + params + ") -> " + body->string() + ")";
+    }
+
+    ValueData LambdaNode::evaluate(VM &) const {
+        if (generator) {
+            // 生成器函数：调用时只绑定参数，函数体在next()时才执行
+            return ValueData{ValueType::Function, false,
+                             [body = body, parameters = parameters, maxSlot = maxSlot](std::vector<ValueData> &args,
+                                                                                       VM &) -> ValueData {
+                                 if (args.size() != parameters.size()) {
+                                     throw std::runtime_error(
+                                         "[squaker.lambda] Argument count mismatch in generator call (expected " +
+                                         std::to_string(parameters.size()) + ", got " + std::to_string(args.size()) +
+                                         ")");
+                                 }
+                                 std::vector<ValueData> locals(maxSlot);
+                                 for (size_t i = 0; i < parameters.size(); i++) {
+                                     locals[parameters[i].slot] = args[i];
+                                 }
+                                 return ValueData{ValueType::Object, false,
+                                                  std::shared_ptr<ObjectData>(
+                                                      std::make_shared<GeneratorData>(body, std::move(locals)))};
+                             }};
+        }
 
-    ValueData LambdaNode::evaluate(VM &vm) const {
-        // 返回一个lambda函数对象
+        // 返回脚本函数对象（函数体与参数表由共享的代码描述持有）
+        auto code = std::make_shared<ScriptFunction::Code>();
+        code->body = body;
+        code->parameters = parameters;
+        code->maxSlot = maxSlot;
         return ValueData{ValueType::Function, false,
-                         [body = body, parameters = parameters, maxSlot = maxSlot](std::vector<ValueData> args,
-                                                                                   VM &vm) -> ValueData {
-                             VMGuard guard(vm, parameters.size());
-
-                             // 检查参数数量是否匹配
-                             // printf("[squaker.lambda] Evaluating lambda with %zu parameters\n", parameters.size());
-                             if (args.size() != parameters.size()) {
-                                 throw std::runtime_error(
-                                     "[squaker.lambda] Argument count mismatch in lambda call (expected " +
-                                     std::to_string(parameters.size()) + ", got " + std::to_string(args.size()) + ")");
-                             }
-
-                             // 设置参数到虚拟机的局部变量
-                             // printf("[squaker.lambda] Setting parameters in VM\n");
-                             for (size_t i = 0; i < parameters.size(); i++) {
-                                 vm.local(parameters[i].slot) = args[i];
-                             }
-
-                             // 执行函数体
-                             // printf("[squaker.lambda] Executing lambda body\n");
-                             try {
-                                 ValueData result = body->evaluate(vm);
-                                 return result; // 返回函数体的结果
-                                 // printf("[squaker.lambda] Lambda execution completed, returning value\n");
-                             } catch (const ReturnException &e) {
-                                 // 捕获返回异常，直接返回结果
-                                 // printf("[squaker.lambda] Lambda returned value: %s\n", e.value.string().c_str());
-                                 return e.value;
-                             }
-
-                             // 如果没有返回异常，默认返回Nil
-                             return ValueData{ValueType::Nil, false, 0.0};
-                         }};
-    }
-
-    ValueData &LambdaNode::evaluate_lvalue(VM &vm) const {
+                         std::function<ValueData(std::vector<ValueData> &, VM &)>(ScriptFunction{std::move(code)})};
+    }
+
+    // 脚本函数调用
+    ValueData ScriptFunction::invoke(const Code &code, ValueData *args, size_t count, VM &vm) {
+        // 检查参数数量是否匹配
+        if (count != code.parameters.size()) {
+            throw std::runtime_error("[squaker.lambda] Argument count mismatch in lambda call (expected " +
+                                     std::to_string(code.parameters.size()) + ", got " + std::to_string(count) + ")");
+        }
+        VMGuard guard(vm, code.maxSlot);
+
+        // 实参归本次调用所有，直接移入局部变量
+        for (size_t i = 0; i < count; i++) {
+            vm.local(code.parameters[i].slot) = std::move(args[i]);
+        }
+
+        // 执行函数体
+        try {
+            return code.body->evaluate(vm); // 返回函数体的结果
+        } catch (ReturnException &e) {
+            return std::move(e.value); // 捕获返回异常，直接返回结果
+        }
+    }
+
+    ValueData &LambdaNode::evaluate_lvalue(VM &) const {
         // Lambda节点通常不支持左值求值
         throw std::runtime_error("[squaker.lambda] Lambda nodes cannot be evaluated as lvalues");
     }
 
     std::unique_ptr<ExprNode> LambdaNode::clone() const {
-        return std::make_unique<LambdaNode>(parameters, body->clone());
+        return std::make_unique<LambdaNode>(parameters, body->clone(), maxSlot, generator);
     }
 
     // 函数应用节点（函数调用）
     ApplyNode::ApplyNode(std::unique_ptr<ExprNode> callee, std::vector<std::unique_ptr<ExprNode>> args)
-        : callee(std::move(callee)), arguments(std::move(args)) {}
+        : callee(std::move(callee)), arguments(std::move(args)), pathArgs(path_mask(arguments)) {
+        if (this->callee->type() == NodeType::ModuleMember) {
+            const ValueData &member = static_cast<const ModuleMemberNode &>(*this->callee).value();
+            if (member.type == ValueType::Function) {
+                const auto &function = std::get<std::function<ValueData(std::vector<ValueData> &, VM &)>>(member.value);
+                if (const auto *script = function.target<ScriptFunction>())
+                    boundCode = script->code.get();
+                boundNative = function.target<NativeFunction>();
+            }
+        }
+    }
 
     std::string ApplyNode::string() const {
         std::string args;
@@ -331,10 +693,10 @@ namespace squ {
         return "(apply:" + callee->string() + "(" + args + "))";
     }
 
-    ValueData ApplyNode::evaluate(VM &vm) const {
+    void ApplyNode::prepare_call(VM &vm, ValueData &calleeVal, std::vector<ValueData> &argValues) const {
         // printf("[squaker.apply] Evaluating function application: %s\n", callee->string().c_str());
         // 计算被调用的函数
-        ValueData calleeVal = callee->evaluate(vm);
+        calleeVal = callee->evaluate(vm);
         // printf("[squaker.apply] Function value type: %d\n", static_cast<int>(calleeVal.type));
         if (calleeVal.type != ValueType::Function) {
             throw std::runtime_error("[squaker.apply] Attempted to call a non-function value");
@@ -342,17 +704,77 @@ namespace squ {
 
         // 准备参数
         // printf("[squaker.apply] Preparing arguments for function call\n");
-        std::vector<ValueData> argValues;
+        argValues.reserve(arguments.size());
         for (const auto &arg : arguments) {
             argValues.push_back(arg->evaluate(vm));
         }
+    }
 
-        // 调用函数
-        // printf("[squaker.apply] Calling function with %zu arguments\n", argValues.size());
-        return std::get<std::function<ValueData(std::vector<ValueData>&, VM &)>>(calleeVal.value)(argValues, vm);
+    ValueData ApplyNode::evaluate(VM &vm) const {
+        // 解析期绑定的模块成员：直接进入调用入口
+        if (boundCode)
+            return call_script(nullptr, *boundCode, vm);
+        if (boundNative) {
+            boundNative->check_arity(arguments.size());
+            return call_native(*boundNative, arguments, pathArgs, vm);
+        }
+
+        // 被调函数只读地取得，不拷贝函数对象
+        ValueData calleeScratch;
+        const ValueData &calleeRef = callee->evaluate_ref(vm, calleeScratch);
+        if (calleeRef.type != ValueType::Function) {
+            throw std::runtime_error("[squaker.apply] Attempted to call a non-function value");
+        }
+        const auto &function = std::get<std::function<ValueData(std::vector<ValueData> &, VM &)>>(calleeRef.value);
+        // 实参的求值可能改写被调函数所在的变量，调用期间持有函数的共享部分（模块成员与进程同寿命，不需要）
+        bool pinned = callee->type() != NodeType::ModuleMember;
+
+        // 取出调用入口：脚本函数直接进入函数体，原生函数直接进入调用桩
+        const ScriptFunction *script = function.target<ScriptFunction>();
+        const NativeFunction *native = script ? nullptr : function.target<NativeFunction>();
+        if (script) {
+            return call_script(pinned ? script->code : nullptr, *script->code, vm);
+        }
+        if (native) {
+            // 原生函数：先检查参数个数，实参借用或放在栈上，直接交给调用桩
+            native->check_arity(arguments.size());
+            if (!pinned)
+                return call_native(*native, arguments, pathArgs, vm);
+            NativeFunction pinnedNative = *native;
+            return call_native(pinnedNative, arguments, pathArgs, vm);
+        }
+
+        // 其他可调用对象（Native注册的函数、生成器函数）：经由 std::function 调用
+        auto call = function; // 实参的求值可能改写被调函数所在的变量
+        std::vector<ValueData> argValues;
+        argValues.reserve(arguments.size());
+        for (const auto &arg : arguments) {
+            argValues.push_back(arg->evaluate(vm));
+        }
+        return call(argValues, vm);
+    }
+
+    ValueData ApplyNode::call_script(std::shared_ptr<const ScriptFunction::Code>, const ScriptFunction::Code &code,
+                                     VM &vm) const {
+        // 实参求值到栈上的数组中，进入新帧后直接移入参数槽位
+        constexpr size_t kInline = 4;
+        size_t count = arguments.size();
+        if (count <= kInline) {
+            ValueData argValues[kInline];
+            for (size_t i = 0; i < count; i++) {
+                argValues[i] = arguments[i]->evaluate(vm);
+            }
+            return ScriptFunction::invoke(code, argValues, count, vm);
+        }
+        std::vector<ValueData> argValues;
+        argValues.reserve(count);
+        for (const auto &arg : arguments) {
+            argValues.push_back(arg->evaluate(vm));
+        }
+        return ScriptFunction::invoke(code, argValues.data(), count, vm);
     }
 
-    ValueData &ApplyNode::evaluate_lvalue(VM &vm) const {
+    ValueData &ApplyNode::evaluate_lvalue(VM &) const {
         // 函数应用通常不支持左值求值
         throw std::runtime_error("[squaker.apply] Apply nodes cannot be evaluated as lvalues");
     }
@@ -386,26 +808,49 @@ namespace squ {
     }
 
     ValueData IfNode::evaluate(VM &vm) const {
+        // 恢复位置：2i为第i个条件，2i+1为第i个分支，2n为else分支
+        Coroutine *co = vm.coroutine();
+        size_t point = resume_from(co, 0);
+        if (point % 2 == 1) {
+            return evaluate_at(*branches[point / 2].second, vm, co, point);
+        }
+
         // 执行条件分支
-        for (const auto &branch : branches) {
-            ValueData condValue = branch.first->evaluate(vm);
-            if (condValue.type == ValueType::Bool && std::get<bool>(condValue.value)) {
-                return branch.second->evaluate(vm); // 条件为真时执行对应分支
-            } else if (condValue.type == ValueType::Integer && std::get<long long>(condValue.value) != 0) {
-                return branch.second->evaluate(vm); // 整数非零视为真
-            } else if (condValue.type == ValueType::Real && std::get<double>(condValue.value) != 0.0) {
-                return branch.second->evaluate(vm); // 实数非零视为真
+        for (size_t i = point / 2; i < branches.size(); i++) {
+            const auto &branch = branches[i];
+            if (condition_at(*branch.first, vm, co, 2 * i)) {
+                return evaluate_at(*branch.second, vm, co, 2 * i + 1); // 条件为真时执行对应分支
             }
         }
         // 如果没有条件匹配且有else分支，执行else分支
         if (elseBranch) {
-            return elseBranch->evaluate(vm);
+            return evaluate_at(*elseBranch, vm, co, 2 * branches.size());
         }
         // 如果没有匹配的分支，返回Nil
         return ValueData{ValueType::Nil};
     }
 
-    ValueData &IfNode::evaluate_lvalue(VM &vm) const {
+    void IfNode::execute(VM &vm) const {
+        // 作为语句执行：分支同样以语句方式执行，不构造分支的值
+        Coroutine *co = vm.coroutine();
+        size_t point = resume_from(co, 0);
+        if (point % 2 == 1) {
+            execute_at(*branches[point / 2].second, vm, co, point);
+            return;
+        }
+        for (size_t i = point / 2; i < branches.size(); i++) {
+            const auto &branch = branches[i];
+            if (condition_at(*branch.first, vm, co, 2 * i)) {
+                execute_at(*branch.second, vm, co, 2 * i + 1);
+                return;
+            }
+        }
+        if (elseBranch) {
+            execute_at(*elseBranch, vm, co, 2 * branches.size());
+        }
+    }
+
+    ValueData &IfNode::evaluate_lvalue(VM &) const {
         // 条件节点通常不支持左值求值
         throw std::runtime_error("[squaker.if] If nodes cannot be evaluated as lvalues");
     }
@@ -422,7 +867,92 @@ namespace squ {
     SwitchNode::SwitchNode(std::unique_ptr<ExprNode> expr, std::vector<std::pair<std::unique_ptr<ExprNode>,
                                                                                  std::unique_ptr<ExprNode>>> cases,
                            std::unique_ptr<ExprNode> defaultCase)
-        : expression(std::move(expr)), cases(std::move(cases)), defaultCase(std::move(defaultCase)) {}
+        : expression(std::move(expr)), cases(std::move(cases)), defaultCase(std::move(defaultCase)) {
+        for (const auto &casePair : this->cases)
+            pathCases = pathCases && is_path(*casePair.first);
+
+        // case值全部是常量（字面量或模块成员）时建立分派表
+        std::vector<const ValueData *> constants;
+        for (const auto &casePair : this->cases) {
+            const ExprNode &label = *casePair.first;
+            if (const auto *literal = dynamic_cast<const LiteralNode *>(&label)) {
+                constants.push_back(&literal->value());
+            } else if (label.type() == NodeType::ModuleMember) {
+                constants.push_back(&static_cast<const ModuleMemberNode &>(label).value());
+            } else {
+                return; // 有非常量的case，按顺序比较
+            }
+        }
+        if (constants.empty())
+            return;
+
+        auto table = std::make_unique<CaseTable>();
+        std::vector<std::pair<long long, size_t>> integers;
+        for (size_t i = 0; i < constants.size(); i++) {
+            const ValueData &value = *constants[i];
+            if (value.type == ValueType::Integer) {
+                integers.emplace_back(std::get<long long>(value.value), i);
+            } else if (value.type == ValueType::String) {
+                table->strings.emplace(std::get<StringData>(value.value), i); // 重复的case值保留第一个
+            } else {
+                table->others.emplace_back(&value, i);
+            }
+        }
+        if (!integers.empty()) {
+            // 按值排序，相同的值保留第一个case
+            std::stable_sort(integers.begin(), integers.end(),
+                             [](const auto &a, const auto &b) { return a.first < b.first; });
+            integers.erase(std::unique(integers.begin(), integers.end(),
+                                       [](const auto &a, const auto &b) { return a.first == b.first; }),
+                           integers.end());
+            // 值域不超过case数的几倍时用密集表，下标直接定位
+            unsigned long long span = static_cast<unsigned long long>(integers.back().first) -
+                                      static_cast<unsigned long long>(integers.front().first);
+            if (span < 4 * integers.size() + 16) {
+                table->base = integers.front().first;
+                table->dense.assign(static_cast<size_t>(span) + 1, CaseTable::npos);
+                for (const auto &[key, index] : integers)
+                    table->dense[static_cast<size_t>(key - table->base)] = index;
+            } else {
+                table->sorted = std::move(integers);
+            }
+        }
+        caseTable = std::move(table);
+    }
+
+    size_t SwitchNode::CaseTable::find(const ValueData &value) const {
+        switch (value.type) {
+            case ValueType::Integer: {
+                long long key = std::get<long long>(value.value);
+                if (!dense.empty()) {
+                    unsigned long long offset =
+                        static_cast<unsigned long long>(key) - static_cast<unsigned long long>(base);
+                    return offset < dense.size() ? dense[static_cast<size_t>(offset)] : npos;
+                }
+                auto it = std::lower_bound(sorted.begin(), sorted.end(), key,
+                                           [](const auto &entry, long long k) { return entry.first < k; });
+                return it != sorted.end() && it->first == key ? it->second : npos;
+            }
+            default: {
+                // 字符串直接按共享的内容查找（哈希值只算一次）；字节视图按内容查找
+                if (value.type == ValueType::String) {
+                    auto it = strings.find(std::get<StringData>(value.value));
+                    return it != strings.end() ? it->second : npos;
+                }
+                std::string_view bytes;
+                if (!strings.empty() && AsBytes(value, bytes)) {
+                    auto it = strings.find(StringData(bytes));
+                    if (it != strings.end())
+                        return it->second;
+                }
+                for (const auto &[constant, index] : others) {
+                    if (constant->type == value.type && ApplyCompare(*constant, CompareOp::Eq, value))
+                        return index;
+                }
+                return npos;
+            }
+        }
+    }
 
     std::string SwitchNode::string() const {
         std::string result = "(switch " + expression->string() + " {\n";
@@ -437,27 +967,69 @@ namespace squ {
     }
 
     ValueData SwitchNode::evaluate(VM &vm) const {
-        // 计算switch表达式的值
-        ValueData exprValue = expression->evaluate(vm);
+        Coroutine *co = vm.coroutine();
+        size_t point;
+        const ExprNode *branch = select(vm, co, point);
+        if (!branch) {
+            return ValueData{ValueType::Nil}; // 如果没有匹配到任何分支，返回Nil
+        }
+        return evaluate_at(*branch, vm, co, point);
+    }
 
-        // 遍历所有case分支
-        for (const auto &casePair : cases) {
-            ValueData caseValue = casePair.first->evaluate(vm);
-            if (caseValue.type == exprValue.type && std::get<bool>(ApplyBinary(caseValue, "==", exprValue).value)){
-                return casePair.second->evaluate(vm); // 匹配到case，执行对应分支
+    void SwitchNode::execute(VM &vm) const {
+        // 作为语句执行：分支同样以语句方式执行，不构造分支的值
+        Coroutine *co = vm.coroutine();
+        size_t point;
+        if (const ExprNode *branch = select(vm, co, point))
+            execute_at(*branch, vm, co, point);
+    }
+
+    const ExprNode *SwitchNode::select(VM &vm, Coroutine *co, size_t &point) const {
+        // 恢复位置：0为switch表达式，i+1为第i个case分支，n+1为default分支
+        // （yield不应出现在case值中，case值在恢复时会被重新求值）
+        point = resume_from(co, 0);
+        if (point > cases.size()) {
+            return defaultCase.get();
+        } else if (point > 0) {
+            return cases[point - 1].second.get();
+        }
+
+        // 计算switch表达式的值（case值没有副作用时直接借用，不拷贝）
+        ValueData exprScratch;
+        const ValueData &exprRef = evaluate_ref_at(*expression, vm, co, 0, exprScratch);
+
+        // 常量case：查表得到分支
+        if (caseTable) {
+            size_t index = caseTable->find(exprRef);
+            if (index != CaseTable::npos) {
+                point = index + 1;
+                return cases[index].second.get();
             }
+            point = cases.size() + 1;
+            return defaultCase.get();
         }
 
-        // 如果没有匹配到case且有default分支，执行default分支
-        if (defaultCase) {
-            return defaultCase->evaluate(vm);
+        if (!pathCases && &exprRef != &exprScratch)
+            exprScratch = exprRef;
+        const ValueData &exprValue = pathCases ? exprRef : exprScratch;
+
+        // 遍历所有case分支
+        for (size_t i = 0; i < cases.size(); i++) {
+            const auto &casePair = cases[i];
+            ValueData caseScratch;
+            const ValueData &caseValue = casePair.first->evaluate_ref(vm, caseScratch);
+            if (ApplyCompare(caseValue, CompareOp::Eq, exprValue)) {
+                point = i + 1;
+                return casePair.second.get(); // 匹配到case，执行对应分支
+            }
         }
 
-        // 如果没有匹配到任何分支，返回Nil
-        return ValueData{ValueType::Nil};
+        // 如果没有匹配到case，执行default分支（可能为空）
+        point = cases.size() + 1;
+        return defaultCase.get();
     }
 
-    ValueData &SwitchNode::evaluate_lvalue(VM &vm) const {
+    ValueData &SwitchNode::evaluate_lvalue(VM &) const {
         // Switch节点通常不支持左值求值
         throw std::runtime_error("[squaker.switch] Switch nodes cannot be evaluated as lvalues");
     }
@@ -483,25 +1055,43 @@ namespace squ {
     }
 
     ValueData ForNode::evaluate(VM &vm) const {
+        ValueData result; // 初始化结果为Nil
+        run(vm, &result);
+        return result; // 返回最后一次循环体的结果
+    }
+
+    void ForNode::execute(VM &vm) const {
+        run(vm, nullptr); // 作为语句执行：循环体同样以语句方式执行，不构造循环的值
+    }
+
+    void ForNode::run(VM &vm, ValueData *result) const {
+        // 恢复位置：0为初始化，1为条件，2为循环体，3为更新
+        Coroutine *co = vm.coroutine();
+        size_t point = resume_from(co, 0);
+
         // 执行初始化
-        if (init)
-            init->evaluate(vm);
-        ValueData result = ValueData{ValueType::Nil}; // 初始化结果为Nil
+        if (init && point == 0)
+            execute_at(*init, vm, co, 0);
         while (true) {
+            if (point == 3) {
+                // 在更新表达式中挂起过，直接从更新继续
+                point = 0;
+                execute_at(*update, vm, co, 3);
+                continue;
+            }
             // 检查循环条件
-            if (condition) {
-                ValueData condValue = condition->evaluate(vm);
-                if (condValue.type == ValueType::Bool && !std::get<bool>(condValue.value)) {
-                    break; // 条件为false时退出循环
-                } else if (condValue.type == ValueType::Integer && std::get<long long>(condValue.value) == 0) {
-                    break; // 如果条件是整数0，视为false
-                } else if (condValue.type == ValueType::Real && std::get<double>(condValue.value) == 0.0) {
-                    break; // 如果条件是实数0.0，视为false
+            if (condition && point < 2) {
+                if (!condition_at(*condition, vm, co, 1)) {
+                    break; // 条件为假时退出循环
                 }
             }
+            point = 0;
             try {
                 // 执行循环体
-                result = body->evaluate(vm);
+                if (result)
+                    *result = evaluate_at(*body, vm, co, 2);
+                else
+                    execute_at(*body, vm, co, 2);
             } catch (const BreakException &) {
                 break; // 捕获break异常，退出循环
             } catch (const ContinueException &) {
@@ -511,12 +1101,11 @@ namespace squ {
             }
             // 更新
             if (update)
-                update->evaluate(vm);
+                execute_at(*update, vm, co, 3);
         }
-        return result; // 返回最后一次循环体的结果
     }
 
-    ValueData &ForNode::evaluate_lvalue(VM &vm) const {
+    ValueData &ForNode::evaluate_lvalue(VM &) const {
         // For循环节点通常不支持左值求值
         throw std::runtime_error("[squaker.for] For nodes cannot be evaluated as lvalues");
     }
@@ -544,13 +1133,27 @@ namespace squ {
             return ValueData{ValueType::Nil}; // 如果没有语句，返回Nil
         }
         ValueData result = ValueData{ValueType::Nil}; // 初始化结果为Nil
-        for (const auto &stmt : statements) {
-            result = stmt->evaluate(vm);
+        // 恢复位置为语句下标
+        Coroutine *co = vm.coroutine();
+        size_t last = statements.size() - 1;
+        for (size_t i = resume_from(co, 0); i < statements.size(); i++) {
+            if (i < last) {
+                execute_at(*statements[i], vm, co, i); // 中间语句的结果不会被使用
+            } else {
+                result = evaluate_at(*statements[i], vm, co, i);
+            }
         }
         return result; // 返回最后一条语句的结果
     }
 
-    ValueData &BlockNode::evaluate_lvalue(VM &vm) const {
+    void BlockNode::execute(VM &vm) const {
+        Coroutine *co = vm.coroutine();
+        for (size_t i = resume_from(co, 0); i < statements.size(); i++) {
+            execute_at(*statements[i], vm, co, i);
+        }
+    }
+
+    ValueData &BlockNode::evaluate_lvalue(VM &) const {
         // 块节点通常不支持左值求值
         throw std::runtime_error("[squaker.block] Block nodes cannot be evaluated as lvalues");
     }
@@ -572,21 +1175,35 @@ namespace squ {
     }
 
     ValueData WhileNode::evaluate(VM &vm) const {
+        ValueData result; // 初始化结果为Nil
+        run(vm, &result);
+        return result; // 返回最后一次循环体的结果
+    }
+
+    void WhileNode::execute(VM &vm) const {
+        run(vm, nullptr); // 作为语句执行：循环体同样以语句方式执行，不构造循环的值
+    }
+
+    void WhileNode::run(VM &vm, ValueData *result) const {
+        // 恢复位置：0为条件，1为循环体
+        Coroutine *co = vm.coroutine();
+        size_t point = resume_from(co, 0);
+
         // 进入作用域并执行循环
-        ValueData result = ValueData{ValueType::Nil}; // 初始化结果为Nil
         while (true) {
-            // 计算条件
-            ValueData condValue = condition->evaluate(vm);
-            if (condValue.type == ValueType::Bool && !std::get<bool>(condValue.value)) {
-                break; // 条件为false时退出循环
-            } else if (condValue.type == ValueType::Integer && std::get<long long>(condValue.value) == 0) {
-                break; // 如果条件是整数0，视为false
-            } else if (condValue.type == ValueType::Real && std::get<double>(condValue.value) == 0.0) {
-                break; // 如果条件是实数0.0，视为false
+            if (point == 0) {
+                // 计算条件
+                if (!condition_at(*condition, vm, co, 0)) {
+                    break; // 条件为假时退出循环
+                }
             }
+            point = 0;
             try {
                 // 执行循环体
-                result = body->evaluate(vm);
+                if (result)
+                    *result = evaluate_at(*body, vm, co, 1);
+                else
+                    execute_at(*body, vm, co, 1);
             } catch (const BreakException &) {
                 break; // 捕获break异常，退出循环
             } catch (const ContinueException &) {
@@ -595,10 +1212,9 @@ namespace squ {
                 throw e; // 直接抛出返回异常
             }
         }
-        return result; // 返回最后一次循环体的结果
     }
 
-    ValueData &WhileNode::evaluate_lvalue(VM &vm) const {
+    ValueData &WhileNode::evaluate_lvalue(VM &) const {
         // While循环节点通常不支持左值求值
         throw std::runtime_error("[squaker.while] While nodes cannot be evaluated as lvalues");
     }
@@ -616,33 +1232,46 @@ namespace squ {
     }
 
     ValueData DoWhileNode::evaluate(VM &vm) const {
+        ValueData result; // 初始化结果为Nil
+        run(vm, &result);
+        return result; // 返回最后一次循环体的结果
+    }
+
+    void DoWhileNode::execute(VM &vm) const {
+        run(vm, nullptr); // 作为语句执行：循环体同样以语句方式执行，不构造循环的值
+    }
+
+    void DoWhileNode::run(VM &vm, ValueData *result) const {
+        // 恢复位置：0为循环体，1为条件
+        Coroutine *co = vm.coroutine();
+        size_t point = resume_from(co, 0);
+
         // 进入作用域并执行循环
-        ValueData result = ValueData{ValueType::Nil}; // 初始化结果为Nil
         do {
-            try {
-                // 执行循环体
-                result = body->evaluate(vm);
-            } catch (const BreakException &) {
-                break; // 捕获break异常，退出循环
-            } catch (const ContinueException &) {
-                continue; // 捕获continue异常，跳过当前循环迭代
-            } catch (const ReturnException &e) {
-                throw e; // 直接抛出返回异常
+            if (point == 0) {
+                try {
+                    // 执行循环体
+                    if (result)
+                        *result = evaluate_at(*body, vm, co, 0);
+                    else
+                        execute_at(*body, vm, co, 0);
+                } catch (const BreakException &) {
+                    break; // 捕获break异常，退出循环
+                } catch (const ContinueException &) {
+                    continue; // 捕获continue异常，跳过当前循环迭代
+                } catch (const ReturnException &e) {
+                    throw e; // 直接抛出返回异常
+                }
             }
+            point = 0;
             // 计算条件
-            ValueData condValue = condition->evaluate(vm);
-            if (condValue.type == ValueType::Bool && !std::get<bool>(condValue.value)) {
-                break; // 条件为false时退出循环
-            } else if (condValue.type == ValueType::Integer && std::get<long long>(condValue.value) == 0) {
-                break; // 如果条件是整数0，视为false
-            } else if (condValue.type == ValueType::Real && std::get<double>(condValue.value) == 0.0) {
-                break; // 如果条件是实数0.0，视为false
+            if (!condition_at(*condition, vm, co, 1)) {
+                break; // 条件为假时退出循环
             }
         } while (true);
-        return result; // 返回最后一次循环体的结果
     }
 
-    ValueData &DoWhileNode::evaluate_lvalue(VM &vm) const {
+    ValueData &DoWhileNode::evaluate_lvalue(VM &) const {
         // Do-While循环节点通常不支持左值求值
         throw std::runtime_error("[squaker.dowhile] DoWhile nodes cannot be evaluated as lvalues");
     }
@@ -656,11 +1285,11 @@ namespace squ {
         return "(import " + moduleName + ")";
     }
 
-    ValueData ImportNode::evaluate(VM &vm) const {
+    ValueData ImportNode::evaluate(VM &) const {
         throw std::runtime_error("[squaker.import] Import nodes cannot be evaluated directly");
     }
 
-    ValueData &ImportNode::evaluate_lvalue(VM &vm) const {
+    ValueData &ImportNode::evaluate_lvalue(VM &) const {
         // 模块导入通常不支持左值求值
         throw std::runtime_error("[squaker.import] Import nodes cannot be evaluated as lvalues");
     }
@@ -674,7 +1303,7 @@ namespace squ {
         return "(" + control_type + ")";
     }
 
-    ValueData ControlFlowNode::evaluate(VM &vm) const {
+    ValueData ControlFlowNode::evaluate(VM &) const {
         // 实现控制流的求值逻辑
         if (control_type == "break") {
             throw BreakException(); // 抛出break异常
@@ -685,7 +1314,7 @@ namespace squ {
         }
     }
 
-    ValueData &ControlFlowNode::evaluate_lvalue(VM &vm) const {
+    ValueData &ControlFlowNode::evaluate_lvalue(VM &) const {
         // 控制流节点通常不支持左值求值
         throw std::runtime_error("[squaker.control] Control flow nodes cannot be evaluated as lvalues");
     }
@@ -709,7 +1338,7 @@ namespace squ {
         throw ReturnException(std::move(returnValue)); // 抛出返回异常
     }
 
-    ValueData &ReturnNode::evaluate_lvalue(VM &vm) const {
+    ValueData &ReturnNode::evaluate_lvalue(VM &) const {
         // 返回值节点通常不支持左值求值
         throw std::runtime_error("[squaker.return] Return nodes cannot be evaluated as lvalues");
     }
@@ -720,24 +1349,63 @@ namespace squ {
 
     // 成员访问节点
     MemberAccessNode::MemberAccessNode(std::unique_ptr<ExprNode> obj, std::string mem)
-        : object(std::move(obj)), member(std::move(mem)) {}
+        : object(std::move(obj)), member(std::move(mem)), symbol(member) {}
 
     std::string MemberAccessNode::string() const {
         return "(" + object->string() + "." + member + ")";
     }
 
     ValueData MemberAccessNode::evaluate(VM &vm) const {
-        // 计算对象的值
-        ValueData objValue = object->evaluate(vm);
+        ValueData scratch;
+        return take_ref(evaluate_ref(vm, scratch), scratch);
+    }
+
+    size_t MemberAccessNode::slot_in(const TableShape &shape) const {
+        uint64_t cached = cache.load(std::memory_order_relaxed);
+        if (static_cast<uint32_t>(cached >> 32) == shape.id()) {
+            return static_cast<uint32_t>(cached); // 命中：形状相同，槽位必然相同
+        }
+        for (const auto &entry : polymorphic) {
+            uint64_t seen = entry.load(std::memory_order_relaxed);
+            if (static_cast<uint32_t>(seen >> 32) == shape.id())
+                return static_cast<uint32_t>(seen);
+        }
+        size_t slot = shape.find(symbol);
+        if (slot != TableShape::npos) {
+            // 前几次未命中时改写单态缓存；之后视为多态位置，保留单态缓存，轮流替换多态条目
+            uint64_t entry = static_cast<uint64_t>(shape.id()) << 32 | slot;
+            uint32_t miss = misses.fetch_add(1, std::memory_order_relaxed);
+            if (miss < kMonomorphicMisses)
+                cache.store(entry, std::memory_order_relaxed);
+            else
+                polymorphic[(miss - kMonomorphicMisses) % kPolymorphicEntries].store(entry, std::memory_order_relaxed);
+        }
+        return slot;
+    }
+
+    const ValueData &MemberAccessNode::evaluate_ref(VM &vm, ValueData &scratch) const {
+        // 只读地取得对象：嵌套的成员访问一路引用，不拷贝中间的表
+        const ValueData &objValue = object->evaluate_ref(vm, scratch);
+
+        // 宿主对象由自身提供成员（对象本身可能就在scratch中，先取出再覆盖）
+        if (objValue.type == ValueType::Object) {
+            std::shared_ptr<ObjectData> obj = std::get<std::shared_ptr<ObjectData>>(objValue.value);
+            scratch = obj->member(member);
+            return scratch;
+        }
 
         // 检查对象类型
         if (objValue.type != ValueType::Table) {
             throw std::runtime_error("[squaker.member] Member access on non-table type: " + objValue.string());
         }
 
-        // 获取映射中的成员
-        auto &map = std::get<TableData>(objValue.value);
-        return map.dot_at(member); // 返回成员值
+        // 按形状取得成员所在的槽位
+        const auto &map = std::get<TableData>(objValue.value);
+        size_t slot = slot_in(*map.shape);
+        if (slot == TableShape::npos) {
+            return map.dot_at(member); // 成员不存在，由表给出错误
+        }
+        return map.members()[slot]; // 返回成员本身
     }
 
     ValueData &MemberAccessNode::evaluate_lvalue(VM &vm) const {
@@ -749,27 +1417,97 @@ namespace squ {
             throw std::runtime_error("[squaker.member] Member access on non-map type: " + objValue.string());
         }
 
-        // 获取映射中的成员
+        // 获取映射中的成员（不存在时加入，表转移到新的形状；冻结的表先解冻）
         auto &map = std::get<TableData>(objValue.value);
-        return map.dot(member); // 返回成员值
+        map.thaw();
+        size_t slot = slot_in(*map.shape);
+        if (slot == TableShape::npos) {
+            return map.dot(symbol);
+        }
+        return map.slots[slot]; // 返回成员值
+    }
+
+    void MemberAccessNode::bind(const TableShape &shape) {
+        size_t slot = shape.find(symbol);
+        if (slot != TableShape::npos) {
+            cache.store(static_cast<uint64_t>(shape.id()) << 32 | slot, std::memory_order_relaxed);
+        }
     }
 
     std::unique_ptr<ExprNode> MemberAccessNode::clone() const {
-        return std::make_unique<MemberAccessNode>(object->clone(), member);
+        auto node = std::make_unique<MemberAccessNode>(object->clone(), member);
+        node->cache.store(cache.load(std::memory_order_relaxed), std::memory_order_relaxed);
+        return node;
+    }
+
+    // 模块成员节点
+    ModuleMemberNode::ModuleMemberNode(std::string module, std::string member, const ValueData *data)
+        : module(std::move(module)), member(std::move(member)), data(data) {}
+
+    std::string ModuleMemberNode::string() const {
+        return "(" + module + "." + member + ")";
+    }
+
+    ValueData ModuleMemberNode::evaluate(VM &) const {
+        return *data;
+    }
+
+    const ValueData &ModuleMemberNode::evaluate_ref(VM &, ValueData &) const {
+        return *data;
+    }
+
+    ValueData &ModuleMemberNode::evaluate_lvalue(VM &) const {
+        throw std::runtime_error("[squaker.module] Module members are read-only: " + module + "." + member);
+    }
+
+    std::unique_ptr<ExprNode> ModuleMemberNode::clone() const {
+        return std::make_unique<ModuleMemberNode>(module, member, data);
     }
 
     // 索引访问节点
     IndexNode::IndexNode(std::unique_ptr<ExprNode> cont, std::unique_ptr<ExprNode> idx)
-        : container(std::move(cont)), index(std::move(idx)) {}
+        : container(std::move(cont)), index(std::move(idx)), pathContainer(is_path(*container)) {}
 
     std::string IndexNode::string() const {
         return "(" + container->string() + "[" + index->string() + "])";
     }
 
     ValueData IndexNode::evaluate(VM &vm) const {
-        // 计算容器和索引
-        ValueData containerValue = container->evaluate(vm);
-        ValueData indexValue = index->evaluate(vm);
+        ValueData scratch;
+        return take_ref(evaluate_ref(vm, scratch), scratch);
+    }
+
+    const ValueData &IndexNode::evaluate_ref(VM &vm, ValueData &scratch) const {
+        // 先求下标，再只读地取得容器（容器求值有副作用时下标按值保存）；嵌套的索引一路引用，不拷贝中间的容器
+        ValueData key;
+        const ValueData &indexValue = pathContainer ? index->evaluate_ref(vm, key) : (key = index->evaluate(vm));
+        const ValueData &containerValue = container->evaluate_ref(vm, scratch);
+
+        // 字符串与字节视图：取第i个字符
+        std::string_view bytes;
+        if (containerValue.type == ValueType::String ||
+            (containerValue.type == ValueType::Object &&
+             std::get<std::shared_ptr<ObjectData>>(containerValue.value)->bytes(bytes))) {
+            if (containerValue.type == ValueType::String)
+                bytes = std::get<StringData>(containerValue.value).view();
+            if (indexValue.type != ValueType::Integer) {
+                throw std::runtime_error("[squaker.index] String index must be an integer: " + indexValue.string());
+            }
+            long long idx = std::get<long long>(indexValue.value);
+            if (idx < 0 || idx >= static_cast<long long>(bytes.size())) {
+                throw std::out_of_range("[squaker.index] String index out of bounds");
+            }
+            char ch = bytes[static_cast<size_t>(idx)]; // 容器可能就在scratch中，先取出字符再覆盖
+            scratch = ValueData{ValueType::Char, false, ch};
+            return scratch;
+        }
+
+        // 按下标读写元素的对象（类型化数组等）：元素读入scratch（对象本身可能就在scratch中，先取出）
+        if (containerValue.type == ValueType::Object && indexValue.type == ValueType::Integer) {
+            std::shared_ptr<ObjectData> obj = std::get<std::shared_ptr<ObjectData>>(containerValue.value);
+            if (obj->element(std::get<long long>(indexValue.value), scratch))
+                return scratch;
+        }
 
         // 检查容器类型
         if (containerValue.type != ValueType::Array && containerValue.type != ValueType::Table) {
@@ -781,28 +1519,21 @@ namespace squ {
             if (indexValue.type != ValueType::Integer) {
                 throw std::runtime_error("[squaker.index] Array index must be an integer: " + indexValue.string());
             }
-            auto &array = std::get<std::vector<ValueData>>(containerValue.value);
+            const auto &array = std::get<std::vector<ValueData>>(containerValue.value);
             long long idx = std::get<long long>(indexValue.value);
             if (idx < 0 || idx >= static_cast<long long>(array.size())) {
                 throw std::out_of_range("[squaker.index] Array index out of bounds");
             }
-            return array[idx]; // 返回数组元素
+            return array[idx]; // 返回数组元素本身
         }
 
         // 处理表索引
-        if (containerValue.type == ValueType::Table) {
-            auto &table = std::get<TableData>(containerValue.value);
-            return table.index_at(indexValue); // 返回表值
-        }
-
-        throw std::runtime_error("[squaker.index] Unsupported container type for indexing");
+        const auto &table = std::get<TableData>(containerValue.value);
+        return table.index_at(indexValue); // 返回表值本身
     }
 
-    ValueData &IndexNode::evaluate_lvalue(VM &vm) const {
-        // 计算容器和索引
-        ValueData &containerValue = container->evaluate_lvalue(vm);
-        ValueData indexValue = index->evaluate(vm);
-
+    // 数组元素或表成员本身
+    static ValueData &element_place(ValueData &containerValue, const ValueData &indexValue) {
         // 检查容器类型
         if (containerValue.type != ValueType::Array && containerValue.type != ValueType::Table) {
             throw std::runtime_error("[squaker.index] Indexing on non-array/map type: " + containerValue.string());
@@ -830,13 +1561,119 @@ namespace squ {
         throw std::runtime_error("[squaker.index] Unsupported container type for indexing");
     }
 
+    ValueData &IndexNode::evaluate_lvalue(VM &vm) const {
+        // 计算容器和索引
+        ValueData &containerValue = container->evaluate_lvalue(vm);
+        ValueData indexValue = index->evaluate(vm);
+        return element_place(containerValue, indexValue);
+    }
+
+    Place IndexNode::place(VM &vm) const {
+        ValueData &containerValue = container->evaluate_lvalue(vm);
+        ValueData indexValue = index->evaluate(vm);
+        Place result;
+        if (containerValue.type == ValueType::Object && indexValue.type == ValueType::Integer) {
+            // 对象的元素：先读出当前值（复合赋值与自增要用），修改后由 commit 写回
+            auto obj = std::get<std::shared_ptr<ObjectData>>(containerValue.value);
+            long long at = std::get<long long>(indexValue.value);
+            if (obj->element(at, result.value)) {
+                result.object = std::move(obj);
+                result.at = at;
+                return result;
+            }
+        }
+        result.ref = &element_place(containerValue, indexValue);
+        return result;
+    }
+
     std::unique_ptr<ExprNode> IndexNode::clone() const {
         return std::make_unique<IndexNode>(container->clone(), index->clone());
     }
 
+    // 切片节点
+    SliceNode::SliceNode(std::unique_ptr<ExprNode> cont, std::unique_ptr<ExprNode> s, std::unique_ptr<ExprNode> e)
+        : container(std::move(cont)), start(std::move(s)), end(std::move(e)) {}
+
+    std::string SliceNode::string() const {
+        return "(" + container->string() + "[" + (start ? start->string() : "") + ":" + (end ? end->string() : "") +
+               "])";
+    }
+
+    ValueData SliceNode::evaluate(VM &vm) const {
+        ValueData containerValue = container->evaluate(vm);
+
+        // 长度
+        size_t length = 0;
+        std::string_view bytes;
+        if (containerValue.type == ValueType::Array) {
+            length = std::get<std::vector<ValueData>>(containerValue.value).size();
+        } else if (containerValue.type == ValueType::String) {
+            length = std::get<StringData>(containerValue.value).size();
+        } else if (containerValue.type == ValueType::Object &&
+                   std::get<std::shared_ptr<ObjectData>>(containerValue.value)->bytes(bytes)) {
+            length = bytes.size();
+        } else if (containerValue.type == ValueType::Table) {
+            // 表：从0开始连续的整数键（如 [1, 2, 3]）
+            const auto &table = std::get<TableData>(containerValue.value);
+            while (table.find_index(ValueData{ValueType::Integer, false, static_cast<long long>(length)}))
+                length++;
+        } else {
+            throw std::runtime_error("[squaker.slice] Slicing on non-string/array/table type: " +
+                                     containerValue.string());
+        }
+
+        // 边界（省略时为开头/结尾）
+        auto bound = [&](const std::unique_ptr<ExprNode> &node, size_t fallback) {
+            if (!node)
+                return fallback;
+            ValueData value = node->evaluate(vm);
+            if (value.type != ValueType::Integer) {
+                throw std::runtime_error("[squaker.slice] Slice bound must be an integer: " + value.string());
+            }
+            long long bound = std::get<long long>(value.value);
+            if (bound < 0 || bound > static_cast<long long>(length)) {
+                throw std::out_of_range("[squaker.slice] Slice bound out of range: " + std::to_string(bound));
+            }
+            return static_cast<size_t>(bound);
+        };
+        size_t from = bound(start, 0);
+        size_t to = bound(end, length);
+        if (from > to) {
+            throw std::out_of_range("[squaker.slice] Slice start is after end");
+        }
+
+        if (containerValue.type == ValueType::Array) {
+            auto &array = std::get<std::vector<ValueData>>(containerValue.value);
+            return ValueData{ValueType::Array, false,
+                             std::vector<ValueData>(std::make_move_iterator(array.begin() + from),
+                                                    std::make_move_iterator(array.begin() + to))};
+        }
+        if (containerValue.type == ValueType::Table) {
+            // 取出的元素从0开始重新编号，成员不保留
+            const auto &table = std::get<TableData>(containerValue.value);
+            TableData result;
+            for (size_t i = from; i < to; i++) {
+                result.index(ValueData{ValueType::Integer, false, static_cast<long long>(i - from)}) =
+                    *table.find_index(ValueData{ValueType::Integer, false, static_cast<long long>(i)});
+            }
+            return ValueData{ValueType::Table, false, std::move(result)};
+        }
+        // 字节视图的切片共享所有者，不拷贝内容
+        return SliceBytes(containerValue, from, to);
+    }
+
+    ValueData &SliceNode::evaluate_lvalue(VM &) const {
+        throw std::runtime_error("[squaker.slice] Slice nodes cannot be evaluated as lvalues");
+    }
+
+    std::unique_ptr<ExprNode> SliceNode::clone() const {
+        return std::make_unique<SliceNode>(container->clone(), start ? start->clone() : nullptr,
+                                           end ? end->clone() : nullptr);
+    }
+
     // 原生函数调用节点
-    NativeCallNode::NativeCallNode(std::string name, std::vector<std::unique_ptr<ExprNode>> args)
-        : functionName(std::move(name)), arguments(std::move(args)) {}
+    NativeCallNode::NativeCallNode(const IntrinsicInfo *intrinsic, std::vector<std::unique_ptr<ExprNode>> args)
+        : intrinsic(intrinsic), arguments(std::move(args)), pathArgs(path_mask(arguments)) {}
 
     std::string NativeCallNode::string() const {
         std::string args;
@@ -845,56 +1682,19 @@ namespace squ {
                 args += ", ";
             args += arguments[i]->string();
         }
-        return "(@" + functionName + "(" + args + "))";
+        return "(@" + intrinsic->name + "(" + args + "))";
     }
 
     ValueData NativeCallNode::evaluate(VM &vm) const {
-        // 标准输出
-        if (functionName == "print") {
-            // 特殊处理print函数
-            for (const auto &arg : arguments) {
-                ValueData argValue = arg->evaluate(vm);
-                std::cout << argValue.string() << " ";
-            }
-            std::cout << std::endl;
-            return ValueData{ValueType::Nil}; // print函数返回Nil
-        }
-        // 打印调用栈
-        if (functionName == "stack") {
-            // 打印当前调用栈
-            vm.printStack();
-            return ValueData{ValueType::Nil}; // stack函数返回Nil
-        }
-        // 打印类型
-        if (functionName == "type") {
-            // 特殊处理type函数
-            ValueData argValue = arguments[0]->evaluate(vm);
-            switch (argValue.type) {
-                case ValueType::Nil:
-                    return ValueData{ValueType::String, false, "nil"};
-                case ValueType::Bool:
-                    return ValueData{ValueType::String, false, "bool"};
-                case ValueType::Integer:
-                    return ValueData{ValueType::String, false, "integer"};
-                case ValueType::Real:
-                    return ValueData{ValueType::String, false, "real"};
-                case ValueType::String: 
-                    return ValueData{ValueType::String, false, "string"};
-                case ValueType::Array: 
-                    return ValueData{ValueType::String, false, "array"};
-                case ValueType::Table: 
-                    return ValueData{ValueType::String, false, "table"};
-                case ValueType::Function: {
-                    return ValueData{ValueType::String, false, "function"};
-                }
-            }
-            return ValueData{ValueType::Nil}; // type函数返回Nil
+        // 语法级内建函数直接拿到参数节点
+        if (intrinsic->call) {
+            return intrinsic->call(arguments, vm);
         }
-        // 其他原生函数调用
-        throw std::runtime_error("Native function call evaluation not implemented for: " + functionName);
+        // 包装的C++函数：参数个数已在解析期检查，实参借用或放在栈上，直接交给调用桩
+        return call_native(*intrinsic->native(), arguments, pathArgs, vm);
     }
 
-    ValueData &NativeCallNode::evaluate_lvalue(VM &vm) const {
+    ValueData &NativeCallNode::evaluate_lvalue(VM &) const {
         // 原生函数调用通常不支持左值求值
         throw std::runtime_error("[squaker.native] Native call nodes cannot be evaluated as lvalues");
     }
@@ -904,7 +1704,7 @@ namespace squ {
         for (const auto &arg : arguments) {
             clonedArgs.push_back(arg->clone());
         }
-        return std::make_unique<NativeCallNode>(functionName, std::move(clonedArgs));
+        return std::make_unique<NativeCallNode>(intrinsic, std::move(clonedArgs));
     }
 
     // 数组节点
@@ -934,7 +1734,7 @@ namespace squ {
         return arrayValue; // 返回创建的数组
     }
 
-    ValueData &ArrayNode::evaluate_lvalue(VM &vm) const {
+    ValueData &ArrayNode::evaluate_lvalue(VM &) const {
         // 数组节点通常不支持左值求值
         throw std::runtime_error("[squaker.array] Array nodes cannot be evaluated as lvalues");
     }
@@ -951,7 +1751,20 @@ namespace squ {
     TableNode::TableNode(std::vector<std::pair<std::unique_ptr<ExprNode>, std::unique_ptr<ExprNode>>> entries,
                          std::vector<std::pair<std::unique_ptr<ExprNode>, std::unique_ptr<ExprNode>>> members,
                          std::vector<std::unique_ptr<ExprNode>> elements)
-        : entries(std::move(entries)), members(std::move(members)), elements(std::move(elements)) {}
+        : entries(std::move(entries)), members(std::move(members)), elements(std::move(elements)) {
+        // 同一字面量创建的表成员名集合相同，共享同一个形状
+        const TableShape *built = TableShape::empty();
+        for (const auto &entry : this->members) {
+            const auto *key = dynamic_cast<const LiteralNode *>(entry.first.get());
+            if (!key || key->value().type != ValueType::String) {
+                return; // 交给求值时报告错误
+            }
+            Symbol name(std::string(std::get<StringData>(key->value().value).view()));
+            built = built->add(name);
+            memberSlots.push_back(built->find(name));
+        }
+        shape = built;
+    }
 
     std::string TableNode::string() const {
         std::string result = "[";
@@ -1011,7 +1824,15 @@ namespace squ {
             }
         }
 
-        // 3.处理成员表部分
+        // 3.处理成员表部分（形状已知时按槽位写入）
+        if (shape) {
+            table.shape = shape;
+            table.slots.resize(shape->size());
+            for (size_t i = 0; i < members.size(); i++) {
+                table.slots[memberSlots[i]] = members[i].second->evaluate(vm);
+            }
+            return ValueData{ValueType::Table, false, std::move(table)};
+        }
         for (const auto &entry : members) {
             if (entry.first->type() != NodeType::Literal) {
                 throw std::runtime_error("[squaker.table] Member keys must be literals: " + entry.first->string());
@@ -1021,13 +1842,13 @@ namespace squ {
                 throw std::runtime_error("[squaker.table] Member keys must be literals: " + key.string());
             }
             ValueData value = entry.second->evaluate(vm);
-            table.dot(std::get<std::string>(key.value)) = value;
+            table.dot(std::string(std::get<StringData>(key.value).view())) = value;
         }
 
         return ValueData{ValueType::Table, false, std::move(table)};
     }
 
-    ValueData &TableNode::evaluate_lvalue(VM &vm) const {
+    ValueData &TableNode::evaluate_lvalue(VM &) const {
         // 表节点通常不支持左值求值
         throw std::runtime_error("[squaker.table] Table nodes cannot be evaluated as lvalues");
     }
@@ -1049,4 +1870,125 @@ namespace squ {
                                            std::move(clonedElements));
     }
 
+    // 记录构造节点
+    RecordNode::RecordNode(const TableShape *shape, std::vector<std::unique_ptr<ExprNode>> fields)
+        : shape(shape), fields(std::move(fields)) {}
+
+    std::string RecordNode::string() const {
+        std::string result = shape->record_name() + "(";
+        for (size_t i = 0; i < fields.size(); i++) {
+            if (i > 0)
+                result += ", ";
+            result += fields[i]->string();
+        }
+        return result + ")";
+    }
+
+    ValueData RecordNode::evaluate(VM &vm) const {
+        TableData record;
+        record.shape = shape;
+        record.slots.resize(shape->size()); // 未给出的字段为Nil
+        for (size_t i = 0; i < fields.size(); i++) {
+            record.slots[i] = fields[i]->evaluate(vm);
+        }
+        return ValueData{ValueType::Table, false, std::move(record)};
+    }
+
+    ValueData &RecordNode::evaluate_lvalue(VM &) const {
+        throw std::runtime_error("[squaker.record] Record construction cannot be evaluated as lvalue");
+    }
+
+    std::unique_ptr<ExprNode> RecordNode::clone() const {
+        std::vector<std::unique_ptr<ExprNode>> clonedFields;
+        for (const auto &field : fields) {
+            clonedFields.push_back(field->clone());
+        }
+        return std::make_unique<RecordNode>(shape, std::move(clonedFields));
+    }
+
+    // 任务派生节点
+    SpawnNode::SpawnNode(std::unique_ptr<ApplyNode> c) : call(std::move(c)) {}
+
+    std::string SpawnNode::string() const {
+        return "(spawn " + call->string() + ")";
+    }
+
+    ValueData SpawnNode::evaluate(VM &vm) const {
+        // 在当前线程求值被调函数与实参，按值拷贝进任务
+        ValueData calleeVal;
+        std::vector<ValueData> argValues;
+        call->prepare_call(vm, calleeVal, argValues);
+
+        auto task = std::make_shared<TaskData>(std::move(calleeVal), std::move(argValues), vm.out.get_sink());
+        Scheduler::instance().submit(task);
+        return ValueData{ValueType::Object, false, std::shared_ptr<ObjectData>(std::move(task))};
+    }
+
+    ValueData &SpawnNode::evaluate_lvalue(VM &) const {
+        // 任务派生不支持左值求值
+        throw std::runtime_error("[squaker.spawn] Spawn nodes cannot be evaluated as lvalues");
+    }
+
+    std::unique_ptr<ExprNode> SpawnNode::clone() const {
+        auto cloned = call->clone();
+        return std::make_unique<SpawnNode>(std::unique_ptr<ApplyNode>(static_cast<ApplyNode *>(cloned.release())));
+    }
+
+    // 任务汇合节点
+    JoinNode::JoinNode(std::unique_ptr<ExprNode> h) : handle(std::move(h)) {}
+
+    std::string JoinNode::string() const {
+        return "(join " + handle->string() + ")";
+    }
+
+    ValueData JoinNode::evaluate(VM &vm) const {
+        ValueData handleVal = handle->evaluate(vm);
+        TaskData *task = nullptr;
+        if (handleVal.type == ValueType::Object) {
+            task = dynamic_cast<TaskData *>(std::get<std::shared_ptr<ObjectData>>(handleVal.value).get());
+        }
+        if (!task) {
+            throw std::runtime_error("[squaker.join] join expects a task handle: " + handleVal.string());
+        }
+        return Scheduler::instance().join(*task, vm);
+    }
+
+    ValueData &JoinNode::evaluate_lvalue(VM &) const {
+        // 任务汇合不支持左值求值
+        throw std::runtime_error("[squaker.join] Join nodes cannot be evaluated as lvalues");
+    }
+
+    std::unique_ptr<ExprNode> JoinNode::clone() const {
+        return std::make_unique<JoinNode>(handle->clone());
+    }
+
+    // 生成器产出节点
+    YieldNode::YieldNode(std::unique_ptr<ExprNode> val) : value(std::move(val)) {}
+
+    std::string YieldNode::string() const {
+        return "(yield " + (value ? value->string() : "void") + ")";
+    }
+
+    ValueData YieldNode::evaluate(VM &vm) const {
+        Coroutine *co = vm.coroutine();
+        if (!co) {
+            throw std::runtime_error("[squaker.yield] yield outside of a generator");
+        }
+        if (co->resuming) {
+            // 恢复到挂起点：yield表达式的值为next()传入的值
+            co->resuming = false;
+            return std::move(co->sent);
+        }
+        throw YieldException(value ? value->evaluate(vm) : ValueData{ValueType::Nil});
+    }
+
+    ValueData &YieldNode::evaluate_lvalue(VM &) const {
+        // 产出节点不支持左值求值
+        throw std::runtime_error("[squaker.yield] Yield nodes cannot be evaluated as lvalues");
+    }
+
+    std::unique_ptr<ExprNode> YieldNode::clone() const {
+        return std::make_unique<YieldNode>(value ? value->clone() : nullptr);
+    }
+
 } // namespace squ
\ No newline at end of file
@@ -1,15 +1,38 @@
 #include "../include/type.h"
 #include "../include/operator.h"
+#include "../include/array.h"
 #include <cmath>
 #include <stdexcept>
 
 namespace squ {
 
+    // 按 .. 的规则追加
+    void AppendConcat(std::string &out, const ValueData &value) {
+        std::string_view bytes;
+        if (value.type == ValueType::String)
+            out += std::get<StringData>(value.value).view();
+        else if (value.type == ValueType::Char)
+            out += std::get<char>(value.value);
+        else if (value.type == ValueType::Object && std::get<std::shared_ptr<ObjectData>>(value.value)->bytes(bytes))
+            out += bytes;
+        else
+            out += value.string();
+    }
+
     // 应用二元操作
     ValueData ApplyBinary(const ValueData &lhs,
                                  const std::string &op,
                                  const ValueData &rhs) {
 
+        //--------------------------------------------------
+        // 类型化数组：逐元素运算
+        //--------------------------------------------------
+        if (lhs.type == ValueType::Object || rhs.type == ValueType::Object) {
+            ValueData result;
+            if (ApplyArrayBinary(lhs, op, rhs, result))
+                return result;
+        }
+
         //--------------------------------------------------
         // 加法 +
         //--------------------------------------------------
@@ -167,20 +190,25 @@ namespace squ {
         // 字符串拼接..
         //--------------------------------------------------
         if (op == "..") {
-            std::string l, r;
-            if (lhs.type == ValueType::String) l = std::get<std::string>(lhs.value);
-            else if (lhs.type == ValueType::Char) l = std::to_string(std::get<char>(lhs.value));
-            else l = lhs.string();
-            if (rhs.type == ValueType::String) r = std::get<std::string>(rhs.value);
-            else if (rhs.type == ValueType::Char) r = std::to_string(std::get<char>(rhs.value));
-            else r = rhs.string();
-            return ValueData{ValueType::String, false, l + r};
+            std::string text;
+            AppendConcat(text, lhs);
+            AppendConcat(text, rhs);
+            return ValueData{ValueType::String, false, std::move(text)};
         }
 
         //--------------------------------------------------
         // 比较操作符
         //--------------------------------------------------
         if (op == "==") {
+            // 两个字符串：共享同一内容（如同一个驻留的字面量）时只比较地址，哈希值已知且不同时不比较内容
+            if (lhs.type == ValueType::String && rhs.type == ValueType::String) {
+                return ValueData{ValueType::Bool, false, std::get<StringData>(lhs.value) == std::get<StringData>(rhs.value)};
+            }
+            // 字符串与字节视图按内容比较
+            std::string_view l, r;
+            if (AsBytes(lhs, l) && AsBytes(rhs, r)) {
+                return ValueData{ValueType::Bool, false, l == r};
+            }
             if (lhs.type == rhs.type) {
                 if (lhs.type == ValueType::Real) {
                     return ValueData{ValueType::Bool, false, std::get<double>(lhs.value) == std::get<double>(rhs.value)};
@@ -188,12 +216,13 @@ namespace squ {
                 if (lhs.type == ValueType::Integer) {
                     return ValueData{ValueType::Bool, false, std::get<long long>(lhs.value) == std::get<long long>(rhs.value)};
                 }
-                if (lhs.type == ValueType::String) {
-                    return ValueData{ValueType::Bool, false, std::get<std::string>(lhs.value) == std::get<std::string>(rhs.value)};
-                }
                 if (lhs.type == ValueType::Char) {
                     return ValueData{ValueType::Bool, false, std::get<char>(lhs.value) == std::get<char>(rhs.value)};
                 }
+                if (lhs.type == ValueType::Object) {
+                    return ValueData{ValueType::Bool, false, std::get<std::shared_ptr<ObjectData>>(lhs.value) ==
+                                                                 std::get<std::shared_ptr<ObjectData>>(rhs.value)};
+                }
                 // 其他类型的比较
                 return ValueData{ValueType::Bool, false, lhs.string() == rhs.string()};
             }
@@ -201,6 +230,14 @@ namespace squ {
         }
 
         if (op == "!=") {
+            if (lhs.type == ValueType::String && rhs.type == ValueType::String) {
+                return ValueData{ValueType::Bool, false, std::get<StringData>(lhs.value) != std::get<StringData>(rhs.value)};
+            }
+            // 字符串与字节视图按内容比较
+            std::string_view l, r;
+            if (AsBytes(lhs, l) && AsBytes(rhs, r)) {
+                return ValueData{ValueType::Bool, false, l != r};
+            }
             if (lhs.type == rhs.type) {
                 if (lhs.type == ValueType::Real) {
                     return ValueData{ValueType::Bool, false, std::get<double>(lhs.value) != std::get<double>(rhs.value)};
@@ -208,12 +245,13 @@ namespace squ {
                 if (lhs.type == ValueType::Integer) {
                     return ValueData{ValueType::Bool, false, std::get<long long>(lhs.value) != std::get<long long>(rhs.value)};
                 }
-                if (lhs.type == ValueType::String) {
-                    return ValueData{ValueType::Bool, false, std::get<std::string>(lhs.value) != std::get<std::string>(rhs.value)};
-                }
                 if (lhs.type == ValueType::Char) {
                     return ValueData{ValueType::Bool, false, std::get<char>(lhs.value) != std::get<char>(rhs.value)};
                 }
+                if (lhs.type == ValueType::Object) {
+                    return ValueData{ValueType::Bool, false, std::get<std::shared_ptr<ObjectData>>(lhs.value) !=
+                                                                 std::get<std::shared_ptr<ObjectData>>(rhs.value)};
+                }
                 // 其他类型的比较
                 return ValueData{ValueType::Bool, false, lhs.string() != rhs.string()};
             }
@@ -440,4 +478,125 @@ namespace squ {
         throw std::runtime_error("[squaker.operator] unknown unary operator: " + op);
     }
 
+    // 复合赋值：原地修改
+    void ApplyCompound(ValueData &place, const std::string &binaryOp, const ValueData &rhs) {
+        if (binaryOp.size() == 1) {
+            char op = binaryOp[0];
+            if (place.type == ValueType::Integer && rhs.type == ValueType::Integer) {
+                long long &l = std::get<long long>(place.value);
+                long long r = std::get<long long>(rhs.value);
+                switch (op) {
+                    case '+':
+                        l += r;
+                        return;
+                    case '-':
+                        l -= r;
+                        return;
+                    case '*':
+                        l *= r;
+                        return;
+                    case '&':
+                        l &= r;
+                        return;
+                    case '|':
+                        l |= r;
+                        return;
+                    case '^':
+                        l ^= r;
+                        return;
+                }
+            } else if (place.type == ValueType::Real &&
+                       (rhs.type == ValueType::Real || rhs.type == ValueType::Integer)) {
+                double &l = std::get<double>(place.value);
+                double r = rhs.type == ValueType::Real ? std::get<double>(rhs.value)
+                                                       : static_cast<double>(std::get<long long>(rhs.value));
+                switch (op) {
+                    case '+':
+                        l += r;
+                        return;
+                    case '-':
+                        l -= r;
+                        return;
+                    case '*':
+                        l *= r;
+                        return;
+                    case '/':
+                        l /= r;
+                        return;
+                }
+            }
+        }
+        place = ApplyBinary(place, binaryOp, rhs);
+    }
+
+    // 自增/自减
+    void ApplyIncrement(ValueData &place, long long delta) {
+        if (place.type == ValueType::Integer) {
+            std::get<long long>(place.value) += delta;
+        } else if (place.type == ValueType::Real) {
+            std::get<double>(place.value) += static_cast<double>(delta);
+        } else {
+            throw std::runtime_error(delta > 0 ? "[squaker.operator:'++'] unsupported type for increment"
+                                               : "[squaker.operator:'--'] unsupported type for decrement");
+        }
+    }
+
+    // 解析比较操作符
+    bool ParseCompareOp(const std::string &op, CompareOp &result) {
+        static const std::pair<const char *, CompareOp> ops[] = {
+            {"==", CompareOp::Eq}, {"!=", CompareOp::Ne}, {"<", CompareOp::Lt},
+            {"<=", CompareOp::Le}, {">", CompareOp::Gt},  {">=", CompareOp::Ge},
+        };
+        for (const auto &[name, value] : ops) {
+            if (op == name) {
+                result = value;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    template <typename T> static bool Compare(T l, CompareOp op, T r) {
+        switch (op) {
+            case CompareOp::Eq:
+                return l == r;
+            case CompareOp::Ne:
+                return l != r;
+            case CompareOp::Lt:
+                return l < r;
+            case CompareOp::Le:
+                return l <= r;
+            case CompareOp::Gt:
+                return l > r;
+            case CompareOp::Ge:
+                return l >= r;
+        }
+        return false;
+    }
+
+    // 比较并直接得到bool
+    bool ApplyCompare(const ValueData &lhs, CompareOp op, const ValueData &rhs) {
+        if (lhs.type == ValueType::Integer && rhs.type == ValueType::Integer) {
+            return Compare(std::get<long long>(lhs.value), op, std::get<long long>(rhs.value));
+        }
+        if (lhs.type == ValueType::Real && rhs.type == ValueType::Real) {
+            return Compare(std::get<double>(lhs.value), op, std::get<double>(rhs.value));
+        }
+        // 整数与实数混合：==/!= 要求类型相同，按 ApplyBinary 的规则处理
+        bool ordering = op != CompareOp::Eq && op != CompareOp::Ne;
+        if (ordering && lhs.type == ValueType::Integer && rhs.type == ValueType::Real) {
+            return Compare(static_cast<double>(std::get<long long>(lhs.value)), op, std::get<double>(rhs.value));
+        }
+        if (ordering && lhs.type == ValueType::Real && rhs.type == ValueType::Integer) {
+            return Compare(std::get<double>(lhs.value), op, static_cast<double>(std::get<long long>(rhs.value)));
+        }
+        if (!ordering && lhs.type == ValueType::String && rhs.type == ValueType::String) {
+            bool equal = std::get<StringData>(lhs.value) == std::get<StringData>(rhs.value);
+            return op == CompareOp::Eq ? equal : !equal;
+        }
+        // 其他类型（字符串、对象、类型化数组等）
+        static const std::string names[] = {"==", "!=", "<", "<=", ">", ">="};
+        return IsTruthy(ApplyBinary(lhs, names[static_cast<int>(op)], rhs));
+    }
+
 } // namespace squ
\ No newline at end of file
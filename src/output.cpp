@@ -0,0 +1,201 @@
+#include "../include/output.h"
+#include <charconv>
+#include <cstdio>
+#include <iostream>
+#include <mutex>
+#include <stdexcept>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace squ {
+
+    // 写入C++输出流（流自己的缓冲照常生效）
+    void StreamSink::write(const char *data, size_t size) {
+        os.write(data, static_cast<std::streamsize>(size));
+    }
+
+    void StreamSink::flush() {
+        os.flush();
+    }
+
+    // 写入文件描述符（处理部分写入）
+    void FdSink::write(const char *data, size_t size) {
+        while (size > 0) {
+#ifdef _WIN32
+            int n = _write(fd, data, static_cast<unsigned int>(size));
+#else
+            ssize_t n = ::write(fd, data, size);
+#endif
+            if (n <= 0) {
+                throw std::runtime_error("[squaker.output] Failed to write to fd " + std::to_string(fd));
+            }
+            data += n;
+            size -= static_cast<size_t>(n);
+        }
+    }
+
+    OutputBuffer::OutputBuffer() : sink(std::make_shared<StreamSink>(std::cout)) {
+#ifdef _WIN32
+        lineBuffered = _isatty(_fileno(stdout)) != 0;
+#else
+        lineBuffered = isatty(fileno(stdout)) != 0;
+#endif
+        buffer.reserve(limit);
+    }
+
+    OutputBuffer::~OutputBuffer() {
+        try {
+            flush();
+        } catch (...) {
+            // 析构时无法报告错误
+        }
+    }
+
+    // 替换接收端
+    void OutputBuffer::set_sink(std::shared_ptr<OutputSink> newSink) {
+        flush();
+        sink = std::move(newSink);
+        lineBuffered = false; // 自定义接收端只按大小或显式刷新
+    }
+
+    // 临时换上另一个接收端
+    std::shared_ptr<OutputSink> OutputBuffer::exchange_sink(std::shared_ptr<OutputSink> newSink) {
+        drain();
+        sink.swap(newSink);
+        return newSink;
+    }
+
+    // 追加原始文本
+    void OutputBuffer::write(std::string_view text) {
+        buffer.append(text);
+        maybe_flush();
+    }
+
+    // 格式化值
+    void OutputBuffer::format(const ValueData &value) {
+        format_into(value);
+        maybe_flush();
+    }
+
+    // 结束一行
+    void OutputBuffer::newline() {
+        buffer.push_back('\n');
+        if (lineBuffered) {
+            drain();
+        } else {
+            maybe_flush();
+        }
+    }
+
+    // 交给接收端并刷新接收端
+    void OutputBuffer::flush() {
+        drain();
+        if (sink) {
+            std::lock_guard<std::mutex> lock(sink->mutex);
+            sink->flush();
+        }
+    }
+
+    // 交给接收端
+    void OutputBuffer::drain() {
+        if (buffer.empty() || !sink)
+            return;
+        // 先清空再写出，接收端抛出异常时不会重复输出
+        std::string pending;
+        pending.swap(buffer);
+        buffer.reserve(limit);
+        std::lock_guard<std::mutex> lock(sink->mutex);
+        sink->write(pending.data(), pending.size());
+    }
+
+    // 递归格式化（与ValueData::string()的输出一致）
+    void OutputBuffer::format_into(const ValueData &value) {
+        switch (value.type) {
+        case ValueType::Nil:
+            buffer.append("nil");
+            return;
+        case ValueType::Integer: {
+            char digits[24];
+            auto result = std::to_chars(digits, digits + sizeof(digits), std::get<long long>(value.value));
+            buffer.append(digits, static_cast<size_t>(result.ptr - digits));
+            return;
+        }
+        case ValueType::Real: {
+            double number = std::get<double>(value.value);
+            char digits[64];
+            int n = std::snprintf(digits, sizeof(digits), "%f", number);
+            if (n >= 0 && static_cast<size_t>(n) < sizeof(digits)) {
+                buffer.append(digits, static_cast<size_t>(n));
+            } else {
+                // 超大数值直接格式化进缓冲区尾部
+                size_t old = buffer.size();
+                buffer.resize(old + static_cast<size_t>(n) + 1);
+                std::snprintf(&buffer[old], static_cast<size_t>(n) + 1, "%f", number);
+                buffer.resize(old + static_cast<size_t>(n));
+            }
+            return;
+        }
+        case ValueType::Bool:
+            buffer.append(std::get<bool>(value.value) ? "true" : "false");
+            return;
+        case ValueType::Char:
+            buffer.push_back('\'');
+            buffer.push_back(std::get<char>(value.value));
+            buffer.push_back('\'');
+            return;
+        case ValueType::String:
+            buffer.push_back('"');
+            buffer.append(std::get<StringData>(value.value).view());
+            buffer.push_back('"');
+            return;
+        case ValueType::Array: {
+            buffer.push_back('[');
+            const auto &arr = std::get<std::vector<ValueData>>(value.value);
+            for (size_t i = 0; i < arr.size(); i++) {
+                if (i > 0)
+                    buffer.append(", ");
+                format_into(arr[i]);
+            }
+            buffer.push_back(']');
+            return;
+        }
+        case ValueType::Table: {
+            buffer.push_back('[');
+            const auto &table = std::get<TableData>(value.value);
+            bool first = true;
+            table.for_each_index([this, &first](const ValueData &key, const ValueData &element) {
+                if (!first)
+                    buffer.append(", ");
+                first = false;
+                format_into(key);
+                buffer.push_back('=');
+                format_into(element);
+            });
+            table.for_each_dot([this, &first](const std::string &name, const ValueData &member) {
+                if (!first)
+                    buffer.append(", ");
+                first = false;
+                buffer.append(name);
+                buffer.append(": ");
+                format_into(member);
+            });
+            buffer.push_back(']');
+            return;
+        }
+        case ValueType::Function:
+            buffer.append("[function]");
+            return;
+        case ValueType::Object:
+            buffer.append(std::get<std::shared_ptr<ObjectData>>(value.value)->string());
+            return;
+        default:
+            buffer.append("[complex_value]");
+            return;
+        }
+    }
+
+} // namespace squ
\ No newline at end of file
@@ -1,19 +1,24 @@
 #include "../include/parser.h"
 #include "../include/scope.h"
 #include "../include/identifier.h"
+#include "../include/intrinsic.h"
 #include "../include/module.h"
+#include "../include/record.h"
+#include <algorithm>
 #include <cmath>
 #include <iostream>
 #include <stdexcept>
+#include <utility>
 
 namespace squ {
 
     // RAII风格的作用域栈管理类
     class ScopeStackGuard {
         Parser *parser;
+        std::unordered_map<size_t, const ValueData *> outerImports; // 外层作用域的导入（槽位属于外层）
 
       public:
-        explicit ScopeStackGuard(Parser *p) : parser(p) {
+        explicit ScopeStackGuard(Parser *p) : parser(p), outerImports(std::exchange(p->imports, {})) {
             parser->scopeStack.emplace(std::move(parser->curScope));
             parser->curScope = std::make_unique<Scope>();
         }
@@ -21,6 +26,7 @@ namespace squ {
             auto oldScope = std::move(parser->scopeStack.top());
             parser->scopeStack.pop();
             parser->curScope = std::move(oldScope);
+            parser->imports = std::move(outerImports);
         }
         ScopeStackGuard(const ScopeStackGuard &) = delete;
         ScopeStackGuard &operator=(const ScopeStackGuard &) = delete;
@@ -118,6 +124,12 @@ namespace squ {
 
         if (match(TokenType::Assignment)) {
             Token op = previous();
+            // 成员已在解析期绑定，导入的模块名不能再被赋值
+            if (left->type() == NodeType::Identifier &&
+                imports.count(static_cast<const IdentifierNode &>(*left).slot())) {
+                throw std::runtime_error("[squaker.parser.import] Cannot assign to imported module: " +
+                                         static_cast<const IdentifierNode &>(*left).identifier());
+            }
             auto right = parse_assignment();
             if (op.value == "=") {
                 // 简单赋值
@@ -138,7 +150,7 @@ namespace squ {
         while (match(TokenType::Operator, "||")) {
             Token op = previous();
             auto right = parse_logical_and();
-            left = std::make_unique<BinaryOpNode>(op.value, std::move(left), std::move(right));
+            left = std::make_unique<LogicalNode>(op.value, std::move(left), std::move(right));
         }
 
         return left;
@@ -151,7 +163,7 @@ namespace squ {
         while (match(TokenType::Operator, "&&")) {
             Token op = previous();
             auto right = parse_equality();
-            left = std::make_unique<BinaryOpNode>(op.value, std::move(left), std::move(right));
+            left = std::make_unique<LogicalNode>(op.value, std::move(left), std::move(right));
         }
 
         return left;
@@ -243,12 +255,26 @@ namespace squ {
             if (op.value == "+" || op.value == "-" || op.value == "!" || op.value == "~" || op.value == "++" ||
                 op.value == "--" || op.value == "&" || op.value == "*") {
                 auto operand = parse_unary();
+                // 数值字面量的正负号在解析期折叠（如 case -1: 仍是常量）
+                if (op.value == "-" || op.value == "+") {
+                    if (const auto *literal = dynamic_cast<const LiteralNode *>(operand.get())) {
+                        ValueType type = literal->value().type;
+                        if (type == ValueType::Integer || type == ValueType::Real)
+                            return std::make_unique<LiteralNode>(ApplyUnary(op.value, literal->value()));
+                    }
+                }
                 return std::make_unique<UnaryOpNode>(op.value, std::move(operand));
             } else {
                 // 不是单目前缀，回退
                 current--;
             }
         }
+        // 前缀自增/减（词法上与复合赋值同属赋值类记号）
+        if (match(TokenType::Assignment, "++") || match(TokenType::Assignment, "--")) {
+            Token op = previous();
+            auto operand = parse_unary();
+            return std::make_unique<UnaryOpNode>(op.value, std::move(operand));
+        }
         return parse_postfix();
     }
 
@@ -261,7 +287,20 @@ namespace squ {
             // 成员访问 a.b
             if (match(TokenType::Punctuation, ".")) {
                 if (match(TokenType::Identifier)) {
-                    expr = std::make_unique<MemberAccessNode>(std::move(expr), previous().value);
+                    auto access = std::make_unique<MemberAccessNode>(std::move(expr), previous().value);
+                    // 声明过的记录字段：按记录的固定布局预置槽位
+                    auto owner = recordFields.find(access->member_name());
+                    if (owner != recordFields.end()) {
+                        access->bind(*owner->second);
+                    }
+                    expr = std::move(access);
+                    // 导入模块的成员直接绑定
+                    if (const ValueData *member = resolve_static(*expr)) {
+                        const auto &access = static_cast<const MemberAccessNode &>(*expr);
+                        expr = std::make_unique<ModuleMemberNode>(
+                            static_cast<const IdentifierNode &>(access.target()).identifier(), access.member_name(),
+                            member);
+                    }
                 } else {
                     std::string context;
                     if (current < tokens.size()) {
@@ -272,7 +311,16 @@ namespace squ {
             }
             // 索引访问 a[i]
             else if (match(TokenType::Punctuation, "[")) {
-                auto index = parse_expression();
+                std::unique_ptr<ExprNode> index;
+                if (!peek(0, TokenType::Punctuation, ":")) {
+                    index = parse_expression();
+                }
+                // 切片访问 a[start:end]
+                bool slice = match(TokenType::Punctuation, ":");
+                std::unique_ptr<ExprNode> end;
+                if (slice && !peek(0, TokenType::Punctuation, "]")) {
+                    end = parse_expression();
+                }
                 if (!match(TokenType::Punctuation, "]")) {
                     std::string context;
                     if (current < tokens.size()) {
@@ -280,7 +328,11 @@ namespace squ {
                     }
                     throw std::runtime_error("[squaker.parser.index] Expected ']' after index expression" + context);
                 }
-                expr = std::make_unique<IndexNode>(std::move(expr), std::move(index));
+                if (slice) {
+                    expr = std::make_unique<SliceNode>(std::move(expr), std::move(index), std::move(end));
+                } else {
+                    expr = std::make_unique<IndexNode>(std::move(expr), std::move(index));
+                }
             }
             // 函数调用
             else if (match(TokenType::Punctuation, "(")) {
@@ -318,9 +370,55 @@ namespace squ {
             }
         }
 
+        // 被调函数在解析期可知时（如 math.sin）提前检查参数
+        if (callee->type() == NodeType::ModuleMember) {
+            const auto &member = static_cast<const ModuleMemberNode &>(*callee);
+            if (const NativeFunction *native = AsNative(member.value())) {
+                check_native_call(member.qualified_name(), *native, arguments);
+            }
+        }
+
         return std::make_unique<ApplyNode>(std::move(callee), std::move(arguments));
     }
 
+    // 解析期可以确定的值（当前函数作用域中导入模块的成员），无法确定时返回空
+    const ValueData *Parser::resolve_static(const ExprNode &expr) const {
+        if (expr.type() != NodeType::MemberAccess) {
+            return nullptr;
+        }
+        const auto &access = static_cast<const MemberAccessNode &>(expr);
+        if (access.target().type() != NodeType::Identifier) {
+            return nullptr;
+        }
+        auto module = imports.find(static_cast<const IdentifierNode &>(access.target()).slot());
+        if (module == imports.end() || module->second->type != ValueType::Table) {
+            return nullptr;
+        }
+        return std::get<TableData>(module->second->value).find_member(access.member_name());
+    }
+
+    // 解析期检查原生函数调用的参数个数与字面量参数的类型
+    void Parser::check_native_call(const std::string &callee, const NativeFunction &native,
+                                   const std::vector<std::unique_ptr<ExprNode>> &arguments) const {
+        if (arguments.size() != native.arity) {
+            throw std::runtime_error("[squaker.parser.call] " + callee + " expects " + std::to_string(native.arity) +
+                                     " argument(s), got " + std::to_string(arguments.size()));
+        }
+        for (size_t i = 0; i < arguments.size(); i++) {
+            // 常量节点也报告为Literal，只检查真正的字面量
+            const auto *literal = dynamic_cast<const LiteralNode *>(arguments[i].get());
+            if (!literal) {
+                continue;
+            }
+            const ValueData &value = literal->value();
+            if (!AcceptsParam(native.params[i], value.type)) {
+                throw std::runtime_error("[squaker.parser.call] Argument " + std::to_string(i + 1) + " of " + callee +
+                                         " has type " + TypeName(value.type) + ", expected " +
+                                         TypeName(native.params[i]));
+            }
+        }
+    }
+
     // 解析块表达式（多语句）
     std::unique_ptr<ExprNode> Parser::parse_block() {
         std::vector<std::unique_ptr<ExprNode>> statements;
@@ -654,10 +752,13 @@ namespace squ {
             slot_parameters.emplace_back(name, slot);
         }
 
-        // 解析函数体
+        // 解析函数体（记录其中是否出现yield）
+        bool outerYield = std::exchange(sawYield, false);
         auto body = parse_expression();
+        bool generator = std::exchange(sawYield, outerYield);
 
-        return std::make_unique<LambdaNode>(std::move(slot_parameters), std::move(body));
+        return std::make_unique<LambdaNode>(std::move(slot_parameters), std::move(body), curScope->size(),
+                                            generator);
     }
 
     // 解析函数定义
@@ -713,11 +814,13 @@ namespace squ {
                 slot_parameters.emplace_back(name, slot);
             }
 
-            // 解析函数体
+            // 解析函数体（记录其中是否出现yield）
+            bool outerYield = std::exchange(sawYield, false);
             auto body = parse_expression();
+            bool generator = std::exchange(sawYield, outerYield);
 
             // 创建函数赋值表达式: functionName = lambda(parameters) -> body
-            lambda = std::make_unique<LambdaNode>(slot_parameters, std::move(body));
+            lambda = std::make_unique<LambdaNode>(slot_parameters, std::move(body), curScope->size(), generator);
         }
 
         // 在当前作用域中添加函数
@@ -727,53 +830,173 @@ namespace squ {
     // 解析导入语句
     std::unique_ptr<ExprNode> Parser::parse_import_statement() {
         // 期望模块名（标识符或字符串）
-        if (match(TokenType::Identifier)) {
-            std::string moduleName = previous().value;
-            auto module = Module(moduleName);
-            // 在当前作用域中注册模块
-            if (curScope->find(moduleName) != Scope::npos) {
-                throw std::runtime_error("[squaker.parser.import] Module already imported: " + moduleName);
-            }
-            size_t slot = curScope->add(moduleName);
-            // 返回导入节点
-            return std::make_unique<AssignmentNode>(
-                "=", std::make_unique<IdentifierNode>(moduleName, slot),
-                std::make_unique<LiteralNode>(module.value)
-            );
-        } else if (match(TokenType::String)) {
-            std::string moduleName = previous().value;
-            auto module = Module(moduleName);
-            // 在当前作用域中注册模块
-            if (curScope->find(moduleName) != Scope::npos) {
-                throw std::runtime_error("[squaker.parser.import] Module already imported: " + moduleName);
-            }
-            size_t slot = curScope->add(moduleName);
-            // 返回导入节点
-            return std::make_unique<AssignmentNode>(
-                "=", std::make_unique<IdentifierNode>(moduleName, slot),
-                std::make_unique<LiteralNode>(module.value)
-            );
-        } else {
+        if (!match(TokenType::Identifier) && !match(TokenType::String)) {
             std::string context;
             if (current < tokens.size()) {
                 context = " at token '" + tokens[current].value + "'";
             }
             throw std::runtime_error("[squaker.parser.import] Expected module name" + context);
         }
+        std::string path = previous().value;
+        const ValueData &module = LoadModule(path, directory);
+        // 绑定的名字：import "lib/my-lib.sq" as mylib，省略时取模块名
+        std::string moduleName;
+        if (peek(0, TokenType::Identifier, "as") && peek(1, TokenType::Identifier)) {
+            current += 2;
+            moduleName = previous().value;
+        } else {
+            moduleName = ModuleBindingName(path);
+        }
+        // 在当前作用域中注册模块
+        if (curScope->find(moduleName) != Scope::npos) {
+            throw std::runtime_error("[squaker.parser.import] Module already imported: " + moduleName);
+        }
+        size_t slot = curScope->add(moduleName);
+        imports[slot] = &module; // 导入的模块，其成员在解析期绑定（槽位属于当前函数作用域）
+        // 返回导入节点
+        return std::make_unique<AssignmentNode>(
+            "=", std::make_unique<IdentifierNode>(moduleName, slot),
+            std::make_unique<LiteralNode>(module)
+        );
+    }
+
+    // 解析记录类型声明
+    std::unique_ptr<ExprNode> Parser::parse_record_declaration() {
+        if (!scopeStack.empty()) {
+            throw std::runtime_error("[squaker.parser.record] Records must be declared at top level");
+        }
+        match(TokenType::Identifier);
+        std::string name = previous().value;
+        if (records.count(name)) {
+            throw std::runtime_error("[squaker.parser.record] Record already declared: " + name);
+        }
+        match(TokenType::Punctuation, "{");
+
+        // 字段列表，以逗号或分号分隔
+        std::vector<std::string> fields;
+        while (!match(TokenType::Punctuation, "}")) {
+            if (!match(TokenType::Identifier)) {
+                std::string context = " at end of input";
+                if (current < tokens.size()) {
+                    context = " at token '" + tokens[current].value + "'";
+                }
+                throw std::runtime_error("[squaker.parser.record] Expected field name in record " + name + context);
+            }
+            std::string field = previous().value;
+            if (std::find(fields.begin(), fields.end(), field) != fields.end()) {
+                throw std::runtime_error("[squaker.parser.record] Duplicate field " + field + " in record " + name);
+            }
+            fields.push_back(std::move(field));
+            if (!match(TokenType::Punctuation, ",")) {
+                match(TokenType::Punctuation, ";");
+            }
+        }
+        if (fields.empty()) {
+            throw std::runtime_error("[squaker.parser.record] Record " + name + " must declare at least one field");
+        }
+
+        const TableShape *shape = TableShape::record(name, fields);
+        records.emplace(name, shape);
+        for (const auto &field : fields) {
+            recordFields.emplace(field, shape);
+        }
+        // 声明本身的值是构造函数
+        return std::make_unique<LiteralNode>(MakeRecordConstructor(*shape));
+    }
+
+    // 解析记录类型名的使用
+    std::unique_ptr<ExprNode> Parser::parse_record_construction(const TableShape &shape) {
+        if (!match(TokenType::Punctuation, "(")) {
+            return std::make_unique<LiteralNode>(MakeRecordConstructor(shape));
+        }
+        std::vector<std::unique_ptr<ExprNode>> fields;
+        if (!match(TokenType::Punctuation, ")")) {
+            do {
+                fields.push_back(parse_expression());
+            } while (match(TokenType::Punctuation, ","));
+            if (!match(TokenType::Punctuation, ")")) {
+                std::string context;
+                if (current < tokens.size()) {
+                    context = " at token '" + tokens[current].value + "'";
+                }
+                throw std::runtime_error("[squaker.parser.record] Expected ')' after field values" + context);
+            }
+        }
+        if (fields.size() > shape.size()) {
+            throw std::runtime_error("[squaker.parser.record] " + shape.record_name() + " expects at most " +
+                                     std::to_string(shape.size()) + " field value(s), got " +
+                                     std::to_string(fields.size()));
+        }
+        return std::make_unique<RecordNode>(&shape, std::move(fields));
     }
 
     // 解析return语句
     std::unique_ptr<ExprNode> Parser::parse_return_statement() {
         // 检查是否有返回值
-        if (current < tokens.size() && tokens[current].type != TokenType::Punctuation) {
+        if (current < tokens.size() && !peek(0, TokenType::Punctuation, ";") && !peek(0, TokenType::Punctuation, "}")) {
             auto value = parse_expression();
             return std::make_unique<ReturnNode>(std::move(value));
         }
         return std::make_unique<ReturnNode>(nullptr); // 无返回值
     }
 
+    // 解析yield语句
+    std::unique_ptr<ExprNode> Parser::parse_yield_statement() {
+        // yield只能出现在函数体内，所在函数因此成为生成器
+        if (scopeStack.empty()) {
+            throw std::runtime_error("[squaker.parser.yield] 'yield' outside of a function");
+        }
+        sawYield = true;
+
+        // 检查是否有产出值（括号开头的表达式也视为产出值）
+        if (current < tokens.size() &&
+            !(tokens[current].type == TokenType::Punctuation && tokens[current].value != "(" &&
+              tokens[current].value != "[" && tokens[current].value != "{")) {
+            auto value = parse_expression();
+            return std::make_unique<YieldNode>(std::move(value));
+        }
+        return std::make_unique<YieldNode>(nullptr); // 无产出值
+    }
+
+    // 解析spawn表达式
+    std::unique_ptr<ExprNode> Parser::parse_spawn_expression() {
+        // spawn 之后必须是一次函数调用
+        auto call = parse_postfix();
+        if (call->type() != NodeType::Apply) {
+            throw std::runtime_error("[squaker.parser.spawn] Expected function call after 'spawn': " + call->string());
+        }
+        return std::make_unique<SpawnNode>(std::unique_ptr<ApplyNode>(static_cast<ApplyNode *>(call.release())));
+    }
+
+    // 解析join表达式
+    std::unique_ptr<ExprNode> Parser::parse_join_expression() {
+        // 期望左括号
+        if (!match(TokenType::Punctuation, "(")) {
+            throw std::runtime_error("[squaker.parser.join] Expected '(' after 'join'");
+        }
+
+        auto handle = parse_expression();
+
+        // 期望右括号
+        if (!match(TokenType::Punctuation, ")")) {
+            std::string context;
+            if (current < tokens.size()) {
+                context = " at token '" + tokens[current].value + "'";
+            }
+            throw std::runtime_error("[squaker.parser.join] Expected ')' after task handle" + context);
+        }
+
+        return std::make_unique<JoinNode>(std::move(handle));
+    }
+
     // 解析原生函数调用
     std::unique_ptr<ExprNode> Parser::parse_native_call(const std::string &functionName) {
+        // 内建函数在解析期查找，调用时不再按名字分派
+        const IntrinsicInfo *intrinsic = FindIntrinsic(functionName);
+        if (!intrinsic) {
+            throw std::runtime_error("[squaker.parser.native] Unknown intrinsic '@" + functionName + "'");
+        }
+
         // 期望左括号
         if (!match(TokenType::Punctuation, "(")) {
             std::string context;
@@ -801,7 +1024,21 @@ namespace squ {
             }
         }
 
-        return std::make_unique<NativeCallNode>(functionName, std::move(arguments));
+        // 检查参数个数（包装的C++函数还检查字面量参数的类型）
+        if (const NativeFunction *native = intrinsic->native()) {
+            check_native_call("@" + functionName, *native, arguments);
+        } else if (arguments.size() < intrinsic->minArgs || arguments.size() > intrinsic->maxArgs) {
+            std::string expected = std::to_string(intrinsic->minArgs);
+            if (intrinsic->maxArgs == IntrinsicInfo::npos) {
+                expected = "at least " + expected;
+            } else if (intrinsic->maxArgs != intrinsic->minArgs) {
+                expected += " to " + std::to_string(intrinsic->maxArgs);
+            }
+            throw std::runtime_error("[squaker.parser.native] @" + functionName + " expects " + expected +
+                                     " argument(s), got " + std::to_string(arguments.size()));
+        }
+
+        return std::make_unique<NativeCallNode>(intrinsic, std::move(arguments));
     }
 
     // 解析常量字面量
@@ -856,7 +1093,7 @@ namespace squ {
                 Token token = previous();
                 ValueData data;
                 data.type = ValueType::String;
-                data.value = token.value;
+                data.value = StringData::intern(token.value); // 键名驻留，存入表的键与字面量共享内容
                 key = std::make_unique<LiteralNode>(data);
                 type = ValueType::String;
             } else {
@@ -949,6 +1186,11 @@ namespace squ {
             else if (token.value == "import") {
                 return parse_import_statement();
             }
+            // 检查record关键字（record Name { ... }，其余情况仍是普通标识符）
+            else if (token.value == "record" && peek(0, TokenType::Identifier) &&
+                     peek(1, TokenType::Punctuation, "{")) {
+                return parse_record_declaration();
+            }
             // 检查break关键字
             else if (token.value == "break") {
                 return std::make_unique<ControlFlowNode>("break");
@@ -961,6 +1203,21 @@ namespace squ {
             else if (token.value == "return") {
                 return parse_return_statement();
             }
+            // 检查yield关键字（后接赋值运算符或已有同名变量时仍是普通标识符）
+            else if (token.value == "yield" && !peek(0, TokenType::Assignment) &&
+                     curScope->find(token.value) == Scope::npos) {
+                return parse_yield_statement();
+            }
+            // 检查spawn关键字（spawn f(...)，其余情况仍是普通标识符）
+            else if (token.value == "spawn" && peek(0, TokenType::Identifier) &&
+                     curScope->find(token.value) == Scope::npos) {
+                return parse_spawn_expression();
+            }
+            // 检查join关键字（join(handle)，其余情况仍是普通标识符）
+            else if (token.value == "join" && peek(0, TokenType::Punctuation, "(") &&
+                     curScope->find(token.value) == Scope::npos) {
+                return parse_join_expression();
+            }
             // 检查原生函数调用（以@开头）
             else if (!token.value.empty() && token.value[0] == '@') {
                 return parse_native_call(token.value.substr(1));
@@ -974,6 +1231,11 @@ namespace squ {
                 // 检查当前作用域中是否有该标识符
                 size_t index = curScope->find(token.value);
                 if (index == Scope::npos) {
+                    // 已声明的记录类型（同名的局部变量优先）
+                    auto record = records.find(token.value);
+                    if (record != records.end()) {
+                        return parse_record_construction(*record->second);
+                    }
                     return std::make_unique<IdentifierNode>(token.value, curScope->add(token.value));
                 }
                 return std::make_unique<IdentifierNode>(token.value, index);
@@ -1000,7 +1262,7 @@ namespace squ {
             Token token = previous();
             ValueData data;
             data.type = ValueType::String;
-            data.value = token.value;
+            data.value = StringData::intern(token.value); // 字面量驻留，相同内容共享同一块，求值时只复制指针
             return std::make_unique<LiteralNode>(data);
         }
 
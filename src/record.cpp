@@ -0,0 +1,148 @@
+#include "../include/record.h"
+#include "../include/identifier.h"
+#include <memory>
+#include <stdexcept>
+
+namespace squ {
+
+    //--------------------------------------------------
+    // 记录构造函数
+    //--------------------------------------------------
+    ValueData RecordConstructor::operator()(std::vector<ValueData> &args, VM &) const {
+        if (args.size() > shape->size()) {
+            throw std::runtime_error("[squaker.record] " + shape->record_name() + " expects at most " +
+                                     std::to_string(shape->size()) + " field value(s), got " +
+                                     std::to_string(args.size()));
+        }
+        TableData record;
+        record.shape = shape;
+        record.slots.resize(shape->size());
+        for (size_t i = 0; i < args.size(); i++) {
+            record.slots[i] = std::move(args[i]);
+        }
+        return ValueData{ValueType::Table, false, std::move(record)};
+    }
+
+    // 包装为脚本值
+    ValueData MakeRecordConstructor(const TableShape &shape) {
+        return ValueData{ValueType::Function, true,
+                         std::function<ValueData(std::vector<ValueData> &, VM &)>(RecordConstructor{&shape})};
+    }
+
+    // 取出函数值中的记录类型
+    const TableShape *AsRecord(const ValueData &function) {
+        if (function.type != ValueType::Function)
+            return nullptr;
+        const auto *constructor = std::get<std::function<ValueData(std::vector<ValueData> &, VM &)>>(function.value)
+                                      .target<RecordConstructor>();
+        return constructor ? constructor->shape : nullptr;
+    }
+
+    //--------------------------------------------------
+    // 记录数组
+    //--------------------------------------------------
+    RecordArray::RecordArray(const TableShape &shape, size_t length)
+        : shape(shape), columns(shape.size(), std::vector<ValueData>(length)), length(length) {}
+
+    // 字符串表示（逐条记录）
+    std::string RecordArray::string() const {
+        std::string result = shape.record_name() + "[";
+        for (size_t i = 0; i < length; i++) {
+            if (i > 0)
+                result += ", ";
+            result += get(i).string();
+        }
+        return result + "]";
+    }
+
+    // 字段所在的列
+    size_t RecordArray::field(const std::string &name) const {
+        size_t slot = shape.find(name);
+        if (slot == TableShape::npos) {
+            throw std::runtime_error("[squaker.record] " + shape.record_name() + " has no field: " + name);
+        }
+        return slot;
+    }
+
+    // 取出第i条记录
+    ValueData RecordArray::get(size_t i) const {
+        TableData record;
+        record.shape = &shape;
+        record.slots.reserve(columns.size());
+        for (const auto &column : columns)
+            record.slots.push_back(column[i]);
+        return ValueData{ValueType::Table, false, std::move(record)};
+    }
+
+    // 写入第i条记录
+    void RecordArray::set(size_t i, const ValueData &record) {
+        if (record.type != ValueType::Table) {
+            throw std::runtime_error("[squaker.record] Expected a " + shape.record_name() + " record, got " +
+                                     record.string());
+        }
+        const auto &table = std::get<TableData>(record.value);
+        if (table.shape == &shape) {
+            // 同类型的记录：槽位与列一一对应
+            for (size_t slot = 0; slot < columns.size(); slot++)
+                columns[slot][i] = table.members()[slot];
+            return;
+        }
+        for (size_t slot = 0; slot < columns.size(); slot++)
+            columns[slot][i] = table.dot_at(shape.name(slot));
+    }
+
+    // 成员
+    ValueData RecordArray::member(const std::string &name) {
+        // 与其他对象类型一样每次访问时绑定，函数持有数组本身（取出的 f = ra.get 在数组被替换后仍然可用）；
+        // 不缓存在数组中，避免数组与绑定的函数互相持有
+        auto self = std::static_pointer_cast<RecordArray>(shared_from_this());
+        auto check = [](const RecordArray &array, long long i) {
+            if (i < 0 || static_cast<size_t>(i) >= array.length) {
+                throw std::out_of_range("[squaker.record] Index out of range: " + std::to_string(i));
+            }
+            return static_cast<size_t>(i);
+        };
+        if (name == "length") {
+            return make_function([self]() { return static_cast<long long>(self->length); });
+        }
+        if (name == "get") {
+            return make_function([self, check](long long i) { return self->get(check(*self, i)); });
+        }
+        if (name == "set") {
+            return make_function([self, check](long long i, const ValueData &record) {
+                self->set(check(*self, i), record);
+            });
+        }
+        if (name == "push") {
+            return make_function([self](const ValueData &record) {
+                for (auto &column : self->columns)
+                    column.emplace_back();
+                self->length++;
+                try {
+                    self->set(self->length - 1, record);
+                } catch (...) {
+                    // 写入失败时撤销追加的一行
+                    for (auto &column : self->columns)
+                        column.pop_back();
+                    self->length--;
+                    throw;
+                }
+            });
+        }
+        if (name == "load") {
+            return make_function([self, check](long long i, const std::string &field) {
+                return self->columns[self->field(field)][check(*self, i)];
+            });
+        }
+        if (name == "store") {
+            return make_function([self, check](long long i, const std::string &field, const ValueData &value) {
+                self->columns[self->field(field)][check(*self, i)] = value;
+            });
+        }
+        if (name == "column") {
+            return make_function([self](const std::string &field) { return self->columns[self->field(field)]; });
+        }
+        return ObjectData::member(name);
+    }
+
+} // namespace squ
\ No newline at end of file
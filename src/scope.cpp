@@ -46,4 +46,9 @@ namespace squ {
         return vars_.size();
     }
 
+    // 最外层块中声明的变量
+    std::vector<std::pair<std::string, size_t>> Scope::bindings() const {
+        return {blockStack.front().begin(), blockStack.front().end()};
+    }
+
 } // namespace squ
\ No newline at end of file
@@ -6,6 +6,7 @@
 #include "../include/type.h"
 #include <chrono>
 #include <cmath>
+#include <filesystem>
 #include <iostream>
 #include <stack>
 #include <string>
@@ -324,6 +325,7 @@ namespace squ {
                     auto expr = parser.parse();      // 解析表达式
                     std::cout << "AST: " << expr->string() << std::endl;
                     auto result = expr->evaluate(vm); // 调用求值接口
+                    vm.out.flush();
                     auto end = std::chrono::high_resolution_clock::now();
                     std::chrono::duration<double> elapsed = end - start;
                     std::cout << GRAY << "(return: " << CYAN << result.string() << GRAY << ", time: " << RED
@@ -332,6 +334,7 @@ namespace squ {
                 }
             } catch (const std::exception &ex) {
                 // 完整代码执行出错时清空缓冲区
+                vm.out.flush();
                 std::cout << RED << ex.what() << RESET << std::endl;
                 input_buffer.clear();
             }
@@ -406,6 +409,16 @@ namespace squ {
         vm.local(slot) = identifier.value;
     }
 
+    void Script::set_output(std::shared_ptr<OutputSink> sink) {
+        vm.out.set_sink(std::move(sink));
+    }
+
+    ValueData Script::execute_file(const std::string &file_path) {
+        std::string source = ReadFile(file_path);
+        parser.directory = std::filesystem::absolute(file_path).parent_path().string();
+        return execute(source);
+    }
+
     ValueData Script::execute(const std::string& code) {
         // 如果传入了代码，则增加到缓冲区
         append(code);
@@ -414,7 +427,7 @@ namespace squ {
         auto result = ValueData{ValueType::Nil, false, 0.0};
 
         // 逐行执行
-        for (; current_index < code.size(); ++current_index) {
+        for (; current_index < this->code.size(); ++current_index) {
             try {
                 const auto &code = this->code[current_index];
                 // 解析tokens
@@ -428,9 +441,11 @@ namespace squ {
                 result = expr->evaluate(vm); // 调用求值接口
             } catch (const std::exception &e) {
                 current_index++; // 跳过错误行
+                vm.out.flush();  // 出错前的输出照常写出
                 throw std::runtime_error(e.what());
             }
         }
+        vm.out.flush();
 
         // 返回结果
         return result;
@@ -0,0 +1,125 @@
+#include "../include/symbol.h"
+#include <deque>
+#include <mutex>
+#include <string_view>
+#include <unordered_map>
+
+namespace squ {
+
+    namespace {
+
+        // 驻留表：deque 保证已驻留项的地址不变，索引的键直接引用项中的文本
+        struct SymbolTable {
+            std::mutex mutex;
+            std::deque<Symbol::Entry> entries;
+            std::unordered_map<std::string_view, const Symbol::Entry *> index;
+        };
+
+        // 有意不释放：形状引用的符号在进程退出时仍然有效
+        SymbolTable &Symbols() {
+            static SymbolTable *table = new SymbolTable();
+            return *table;
+        }
+
+        // 字符串字面量的驻留表：索引的键直接引用块中的文本
+        template <typename Rep> struct StringTable {
+            std::mutex mutex;
+            std::unordered_map<std::string_view, std::shared_ptr<Rep>> index;
+        };
+
+    } // namespace
+
+    Symbol::Symbol(const std::string &text) {
+        SymbolTable &table = Symbols();
+        std::lock_guard<std::mutex> lock(table.mutex);
+        auto it = table.index.find(text);
+        if (it != table.index.end()) {
+            entry = it->second;
+            return;
+        }
+        table.entries.push_back({text, std::hash<std::string_view>{}(text)});
+        entry = &table.entries.back();
+        table.index.emplace(entry->text, entry);
+    }
+
+    StringData::StringData(std::string text) {
+        if (!text.empty())
+            rep = std::make_shared<Rep>(std::move(text));
+    }
+
+    // 不超过短字符串缓冲的子串复制与建切片一样只分配一次，还不会让源块一直留着
+    StringData StringData::slice(size_t start, size_t end) const {
+        std::string_view content = view().substr(start, end - start);
+        if (content.size() < sizeof(std::string))
+            return StringData(content);
+        StringData result;
+        result.rep = std::make_shared<Rep>(std::string());
+        result.rep->base = rep->base ? rep->base : rep; // 切片的切片直接引用最初的块
+        result.rep->part = content;
+        return result;
+    }
+
+    const std::string &StringData::flat() {
+        if (!rep) {
+            static const std::string *empty = new std::string();
+            return *empty;
+        }
+        if (rep->base)
+            rep = std::make_shared<Rep>(std::string(rep->part));
+        return rep->text;
+    }
+
+    // 驻留表有意不释放：语法树中的字面量在进程退出时仍然有效
+    StringData StringData::intern(std::string_view text) {
+        static auto *table = new StringTable<Rep>();
+        StringData result;
+        if (text.empty())
+            return result;
+        std::lock_guard<std::mutex> lock(table->mutex);
+        auto it = table->index.find(text);
+        if (it != table->index.end()) {
+            result.rep = it->second;
+            return result;
+        }
+        result.rep = std::make_shared<Rep>(std::string(text));
+        result.rep->interned = true;
+        result.hash();
+        table->index.emplace(result.rep->text, result.rep);
+        return result;
+    }
+
+    std::string &StringData::edit() {
+        if (!rep) {
+            rep = std::make_shared<Rep>(std::string());
+        } else if (rep->base || rep->interned || rep.use_count() != 1) {
+            rep = std::make_shared<Rep>(std::string(view()));
+        } else {
+            rep->hash.store(0, std::memory_order_relaxed);
+        }
+        return rep->text;
+    }
+
+    size_t StringData::hash() const {
+        if (!rep)
+            return std::hash<std::string_view>{}(std::string_view());
+        size_t cached = rep->hash.load(std::memory_order_relaxed);
+        if (cached == 0) {
+            cached = std::hash<std::string_view>{}(view());
+            rep->hash.store(cached, std::memory_order_relaxed);
+        }
+        return cached;
+    }
+
+    bool StringData::operator==(const StringData &other) const {
+        if (rep == other.rep)
+            return true;
+        if (rep && other.rep) {
+            size_t a = rep->hash.load(std::memory_order_relaxed);
+            size_t b = other.rep->hash.load(std::memory_order_relaxed);
+            if (a != 0 && b != 0 && a != b)
+                return false;
+        }
+        return view() == other.view();
+    }
+
+} // namespace squ
\ No newline at end of file
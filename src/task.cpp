@@ -0,0 +1,250 @@
+#include "../include/task.h"
+#include <chrono>
+#include <stdexcept>
+
+namespace squ {
+
+    // 当前线程对应的工作线程编号（非工作线程为npos）
+    static constexpr size_t npos = static_cast<size_t>(-1);
+    static thread_local size_t currentWorker = npos;
+    // 当前线程在 join 中嵌套窃取执行其他任务的层数
+    static thread_local size_t helpDepth = 0;
+
+    // 在给定虚拟机上执行任务
+    void TaskData::run(VM &vm) {
+        try {
+            if (callee.type != ValueType::Function) {
+                throw std::runtime_error("[squaker.task] Attempted to spawn a non-function value");
+            }
+            value = std::get<std::function<ValueData(std::vector<ValueData> &, VM &)>>(callee.value)(args, vm);
+        } catch (...) {
+            error = std::current_exception();
+        }
+        // 参数不再需要，尽早释放
+        args.clear();
+        {
+            // 在锁内标记完成，等待方检查条件与进入等待之间不会漏掉通知
+            std::lock_guard<std::mutex> lock(mutex);
+            finished.store(true, std::memory_order_release);
+        }
+        doneSignal.notify_all();
+    }
+
+    // 取回结果
+    ValueData TaskData::result() const {
+        if (error) {
+            std::rethrow_exception(error);
+        }
+        return value;
+    }
+
+    // 工作窃取双端队列
+    WorkStealingDeque::WorkStealingDeque(size_t capacity) {
+        size_t cap = 1;
+        while (cap < capacity)
+            cap <<= 1;
+        buffer.store(new Buffer(cap), std::memory_order_relaxed);
+    }
+
+    WorkStealingDeque::~WorkStealingDeque() {
+        delete buffer.load(std::memory_order_relaxed);
+    }
+
+    // 扩容为两倍容量并拷贝仍在队列中的任务
+    WorkStealingDeque::Buffer *WorkStealingDeque::grow(Buffer *old, int64_t b, int64_t t) {
+        auto *next = new Buffer(old->capacity() * 2);
+        for (int64_t i = t; i < b; ++i) {
+            next->put(i, old->get(i));
+        }
+        retired.emplace_back(old);
+        buffer.store(next, std::memory_order_release);
+        return next;
+    }
+
+    // 所有者线程：压入底部
+    void WorkStealingDeque::push(TaskData *task) {
+        int64_t b = bottom.load(std::memory_order_relaxed);
+        int64_t t = top.load(std::memory_order_acquire);
+        Buffer *a = buffer.load(std::memory_order_relaxed);
+        if (b - t > static_cast<int64_t>(a->capacity()) - 1) {
+            a = grow(a, b, t);
+        }
+        a->put(b, task);
+        std::atomic_thread_fence(std::memory_order_release);
+        bottom.store(b + 1, std::memory_order_relaxed);
+    }
+
+    // 所有者线程：从底部弹出
+    TaskData *WorkStealingDeque::pop() {
+        int64_t b = bottom.load(std::memory_order_relaxed) - 1;
+        Buffer *a = buffer.load(std::memory_order_relaxed);
+        bottom.store(b, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64_t t = top.load(std::memory_order_relaxed);
+        if (t > b) {
+            // 队列为空
+            bottom.store(b + 1, std::memory_order_relaxed);
+            return nullptr;
+        }
+        TaskData *task = a->get(b);
+        if (t == b) {
+            // 只剩最后一个元素，与窃取者竞争
+            if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+                task = nullptr;
+            }
+            bottom.store(b + 1, std::memory_order_relaxed);
+        }
+        return task;
+    }
+
+    // 任意线程：从顶部窃取
+    TaskData *WorkStealingDeque::steal() {
+        int64_t t = top.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64_t b = bottom.load(std::memory_order_acquire);
+        if (t >= b) {
+            return nullptr;
+        }
+        Buffer *a = buffer.load(std::memory_order_acquire);
+        TaskData *task = a->get(t);
+        if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+            return nullptr; // 竞争失败，由调用者重试其他队列
+        }
+        return task;
+    }
+
+    // 调度器单例
+    Scheduler &Scheduler::instance() {
+        static Scheduler scheduler;
+        return scheduler;
+    }
+
+    Scheduler::Scheduler() {
+        size_t count = std::thread::hardware_concurrency();
+        if (count == 0)
+            count = 1;
+        for (size_t i = 0; i < count; ++i) {
+            auto worker = std::make_unique<Worker>();
+            worker->vm.enter(0); // 任务帧压在这个基础帧之上
+            workers.push_back(std::move(worker));
+        }
+        // 所有队列建好后再启动线程，窃取时不会访问到未初始化的工作线程
+        for (size_t i = 0; i < count; ++i) {
+            workers[i]->thread = std::thread(&Scheduler::worker_loop, this, i);
+        }
+    }
+
+    Scheduler::~Scheduler() {
+        stopping.store(true, std::memory_order_release);
+        wakeup.notify_all();
+        for (auto &worker : workers) {
+            if (worker->thread.joinable())
+                worker->thread.join();
+        }
+        // 释放仍在排队的任务
+        for (auto &worker : workers) {
+            while (TaskData *task = worker->deque.pop())
+                task->keepAlive.reset();
+        }
+        for (TaskData *task : injected)
+            task->keepAlive.reset();
+    }
+
+    // 提交任务
+    void Scheduler::submit(const std::shared_ptr<TaskData> &task) {
+        task->keepAlive = task;
+        pending.fetch_add(1, std::memory_order_release);
+        if (currentWorker != npos) {
+            workers[currentWorker]->deque.push(task.get());
+        } else {
+            std::lock_guard<std::mutex> lock(mutex);
+            injected.push_back(task.get());
+        }
+        wakeup.notify_one();
+    }
+
+    // 执行任务并释放调度器持有的引用
+    void Scheduler::execute(TaskData *task, VM &vm) {
+        pending.fetch_sub(1, std::memory_order_relaxed);
+        std::shared_ptr<TaskData> hold = std::move(task->keepAlive);
+        // 输出写入派生任务的虚拟机的接收端（宿主用 Script::set_output 捕获时不会丢失）；
+        // 任务边界刷新，工作线程的输出不会滞留在缓冲区中，之后恢复执行它的虚拟机原来的接收端
+        std::shared_ptr<OutputSink> own = vm.out.exchange_sink(task->sink);
+        task->run(vm);
+        vm.out.exchange_sink(std::move(own));
+    }
+
+    // 寻找可执行的任务
+    TaskData *Scheduler::find_work(size_t self) {
+        if (pending.load(std::memory_order_acquire) == 0) {
+            return nullptr;
+        }
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (!injected.empty()) {
+                TaskData *task = injected.front();
+                injected.pop_front();
+                return task;
+            }
+        }
+        // 从相邻的工作线程开始轮流窃取
+        size_t count = workers.size();
+        size_t start = self == npos ? 0 : self + 1;
+        for (size_t i = 0; i < count; ++i) {
+            size_t victim = (start + i) % count;
+            if (victim == self)
+                continue;
+            if (TaskData *task = workers[victim]->deque.steal())
+                return task;
+        }
+        return nullptr;
+    }
+
+    // 工作线程主循环
+    void Scheduler::worker_loop(size_t index) {
+        currentWorker = index;
+        Worker &self = *workers[index];
+        while (!stopping.load(std::memory_order_acquire)) {
+            TaskData *task = self.deque.pop();
+            if (!task)
+                task = find_work(index);
+            if (task) {
+                execute(task, self.vm);
+                continue;
+            }
+            // 没有任务时短暂休眠，提交任务会唤醒
+            std::unique_lock<std::mutex> lock(mutex);
+            wakeup.wait_for(lock, std::chrono::milliseconds(1), [this] {
+                return stopping.load(std::memory_order_acquire) || pending.load(std::memory_order_acquire) > 0;
+            });
+        }
+    }
+
+    // 等待任务完成，期间帮助执行其他任务。
+    // 自己队列中的任务是当前计算派生的，执行它们的嵌套深度受脚本自身的递归深度限制；
+    // 窃取来的任务与当前计算无关，它们再 join 时又会窃取，嵌套没有上限，所以只在层数不多时窃取
+    ValueData Scheduler::join(TaskData &task, VM &vm) {
+        size_t self = currentWorker;
+        while (!task.done()) {
+            TaskData *next = self != npos ? workers[self]->deque.pop() : nullptr;
+            if (next) {
+                execute(next, vm);
+                continue;
+            }
+            if (helpDepth < kMaxHelpDepth) {
+                next = find_work(self);
+                if (next) {
+                    ++helpDepth;
+                    execute(next, vm);
+                    --helpDepth;
+                    continue;
+                }
+            }
+            // 没有可帮助的任务：阻塞等待任务完成，每隔1毫秒重新检查是否有新派生或注入的任务可以帮助
+            std::unique_lock<std::mutex> lock(task.mutex);
+            task.doneSignal.wait_for(lock, std::chrono::milliseconds(1), [&task] { return task.done(); });
+        }
+        return task.result();
+    }
+
+} // namespace squ
\ No newline at end of file
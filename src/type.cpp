@@ -1,5 +1,9 @@
 #include "../include/type.h"
+#include <algorithm>
+#include <atomic>
 #include <sstream>
+#include <stdexcept>
+#include <unordered_map>
 
 namespace squ {
 
@@ -9,39 +13,489 @@ namespace squ {
         return &a < &b;
     }
 
+    bool operator<(const ValueData &a, const ValueData &b) noexcept;
+
+    //--------------------------------------------------
+    // 持久化有序映射
+    //--------------------------------------------------
+    struct PersistentMap::Node {
+        ValueData key;
+        ValueData value;
+        std::shared_ptr<const Node> left;
+        std::shared_ptr<const Node> right;
+        int height = 1;
+    };
+
+    namespace {
+
+        using NodePtr = std::shared_ptr<const PersistentMap::Node>;
+
+        int Height(const NodePtr &node) {
+            return node ? node->height : 0;
+        }
+
+        NodePtr MakeNode(ValueData key, ValueData value, NodePtr left, NodePtr right) {
+            auto node = std::make_shared<PersistentMap::Node>();
+            node->key = std::move(key);
+            node->value = std::move(value);
+            node->height = std::max(Height(left), Height(right)) + 1;
+            node->left = std::move(left);
+            node->right = std::move(right);
+            return node;
+        }
+
+        // 以给定的键值和左右子树组装节点，左右高度差超过1时旋转（只新建路径上的节点）
+        NodePtr Balance(ValueData key, ValueData value, NodePtr left, NodePtr right) {
+            int lh = Height(left), rh = Height(right);
+            if (lh > rh + 1) {
+                if (Height(left->left) >= Height(left->right)) {
+                    return MakeNode(left->key, left->value, left->left,
+                                    MakeNode(std::move(key), std::move(value), left->right, std::move(right)));
+                }
+                return MakeNode(left->right->key, left->right->value,
+                                MakeNode(left->key, left->value, left->left, left->right->left),
+                                MakeNode(std::move(key), std::move(value), left->right->right, std::move(right)));
+            }
+            if (rh > lh + 1) {
+                if (Height(right->right) >= Height(right->left)) {
+                    return MakeNode(right->key, right->value,
+                                    MakeNode(std::move(key), std::move(value), std::move(left), right->left),
+                                    right->right);
+                }
+                return MakeNode(right->left->key, right->left->value,
+                                MakeNode(std::move(key), std::move(value), std::move(left), right->left->left),
+                                MakeNode(right->key, right->value, right->left->right, right->right));
+            }
+            return MakeNode(std::move(key), std::move(value), std::move(left), std::move(right));
+        }
+
+        NodePtr Insert(const NodePtr &node, const ValueData &key, ValueData value, bool &added) {
+            if (!node) {
+                added = true;
+                return MakeNode(key, std::move(value), nullptr, nullptr);
+            }
+            if (key < node->key) {
+                return Balance(node->key, node->value, Insert(node->left, key, std::move(value), added), node->right);
+            }
+            if (node->key < key) {
+                return Balance(node->key, node->value, node->left, Insert(node->right, key, std::move(value), added));
+            }
+            return MakeNode(node->key, std::move(value), node->left, node->right);
+        }
+
+        // 删除最小的节点，取出其键值
+        NodePtr RemoveMin(const NodePtr &node, ValueData &key, ValueData &value) {
+            if (!node->left) {
+                key = node->key;
+                value = node->value;
+                return node->right;
+            }
+            return Balance(node->key, node->value, RemoveMin(node->left, key, value), node->right);
+        }
+
+        NodePtr Remove(const NodePtr &node, const ValueData &key, bool &removed) {
+            if (!node) {
+                return nullptr;
+            }
+            if (key < node->key) {
+                NodePtr left = Remove(node->left, key, removed);
+                return removed ? Balance(node->key, node->value, std::move(left), node->right) : node;
+            }
+            if (node->key < key) {
+                NodePtr right = Remove(node->right, key, removed);
+                return removed ? Balance(node->key, node->value, node->left, std::move(right)) : node;
+            }
+            removed = true;
+            if (!node->left)
+                return node->right;
+            if (!node->right)
+                return node->left;
+            ValueData nextKey, nextValue;
+            NodePtr right = RemoveMin(node->right, nextKey, nextValue);
+            return Balance(std::move(nextKey), std::move(nextValue), node->left, std::move(right));
+        }
+
+        void Visit(const PersistentMap::Node *node,
+                   const std::function<void(const ValueData &, const ValueData &)> &f) {
+            while (node) {
+                Visit(node->left.get(), f);
+                f(node->key, node->value);
+                node = node->right.get();
+            }
+        }
+
+    } // namespace
+
+    const ValueData *PersistentMap::find(const ValueData &key) const {
+        const Node *node = root.get();
+        while (node) {
+            if (key < node->key)
+                node = node->left.get();
+            else if (node->key < key)
+                node = node->right.get();
+            else
+                return &node->value;
+        }
+        return nullptr;
+    }
+
+    PersistentMap PersistentMap::set(const ValueData &key, ValueData value) const {
+        bool added = false;
+        PersistentMap result;
+        result.root = Insert(root, key, std::move(value), added);
+        result.count = count + (added ? 1 : 0);
+        return result;
+    }
+
+    PersistentMap PersistentMap::erase(const ValueData &key) const {
+        bool removed = false;
+        PersistentMap result;
+        result.root = Remove(root, key, removed);
+        result.count = count - (removed ? 1 : 0);
+        return result;
+    }
+
+    void PersistentMap::for_each(const std::function<void(const ValueData &, const ValueData &)> &f) const {
+        Visit(root.get(), f);
+    }
+
+    //--------------------------------------------------
+    // 表
+    //--------------------------------------------------
+
+    // 冻结值中嵌套的表（数组按元素处理）
+    static void FreezeValue(ValueData &value) {
+        if (value.type == ValueType::Table) {
+            std::get<TableData>(value.value).freeze();
+        } else if (value.type == ValueType::Array) {
+            for (auto &element : std::get<std::vector<ValueData>>(value.value))
+                FreezeValue(element);
+        }
+    }
+
+    // 转为冻结表示
+    void TableData::freeze() {
+        if (frozen()) {
+            return;
+        }
+        PersistentMap array;
+        for (auto &[key, value] : array_map) {
+            FreezeValue(value);
+            array = array.set(key, std::move(value));
+        }
+        for (auto &value : slots)
+            FreezeValue(value);
+        frozen_array = std::move(array);
+        frozen_slots = std::make_shared<const std::vector<ValueData>>(std::move(slots));
+        array_map.clear();
+        slots.clear();
+    }
+
+    // 解冻：把共享的内容拷贝回普通表示（嵌套的表保持冻结，写入它们时各自解冻）
+    void TableData::thaw() {
+        if (!frozen()) {
+            return;
+        }
+        ArrayMap array;
+        frozen_array.for_each([&array](const ValueData &key, const ValueData &value) {
+            array.emplace_hint(array.end(), key, value);
+        });
+        array_map = std::move(array);
+        slots = *frozen_slots;
+        frozen_array = PersistentMap();
+        frozen_slots.reset();
+    }
+
+    // 查找数组部分的键
+    const ValueData *TableData::find_index(const ValueData &index) const {
+        if (frozen()) {
+            return frozen_array.find(index);
+        }
+        auto it = array_map.find(index);
+        return it == array_map.end() ? nullptr : &it->second;
+    }
+
+    // 按键的顺序遍历数组部分
+    void TableData::for_each_index(const std::function<void(const ValueData &, const ValueData &)> &f) const {
+        if (frozen()) {
+            frozen_array.for_each(f);
+            return;
+        }
+        for (const auto &[key, value] : array_map)
+            f(key, value);
+    }
+
+    // 更新一个键后的冻结表
+    TableData TableData::with(const ValueData &index, ValueData value) const {
+        TableData result = *this;
+        result.freeze();
+        FreezeValue(value);
+        std::string_view name;
+        if (AsBytes(index, name)) {
+            size_t slot = shape->find(std::string(name));
+            if (slot != TableShape::npos) {
+                // 成员值整体共享，更新时复制一份成员数组
+                auto values = *result.frozen_slots;
+                values[slot] = std::move(value);
+                result.frozen_slots = std::make_shared<const std::vector<ValueData>>(std::move(values));
+                return result;
+            }
+        }
+        result.frozen_array = result.frozen_array.set(TableKey(index), std::move(value));
+        return result;
+    }
+
+    // 删除一个键后的冻结表
+    TableData TableData::without(const ValueData &index) const {
+        TableData result = *this;
+        result.freeze();
+        result.frozen_array = result.frozen_array.erase(index);
+        std::string_view name;
+        if (AsBytes(index, name)) {
+            size_t slot = shape->find(std::string(name));
+            if (slot != TableShape::npos) {
+                if (shape->sealed()) {
+                    throw std::runtime_error("[squaker.record] Cannot remove field " + std::string(name) + " from " +
+                                             shape->record_name());
+                }
+                auto values = *result.frozen_slots;
+                values.erase(values.begin() + static_cast<std::ptrdiff_t>(slot));
+                result.shape = shape->remove(slot);
+                result.frozen_slots = std::make_shared<const std::vector<ValueData>>(std::move(values));
+            }
+        }
+        return result;
+    }
+
     // 实现TableData的index成员函数
     ValueData &TableData::index(const ValueData &index) {
+        thaw();
+        if (index.type == ValueType::Object)
+            return array_map[TableKey(index)];
         return array_map[index];
     }
 
+    // 存入表的键
+    ValueData TableKey(const ValueData &key) {
+        std::string_view bytes;
+        if (key.type == ValueType::Object && AsBytes(key, bytes))
+            return ValueData{ValueType::String, false, std::string(bytes)};
+        return key;
+    }
+
+    // 删除数组部分的键
+    bool TableData::erase(const ValueData &index) {
+        thaw();
+        return array_map.erase(index) > 0;
+    }
+
     // 实现TableData的index_at成员函数
     ValueData &TableData::index_at(const ValueData &index) {
-        if (index.type != ValueType::String && index.type != ValueType::Integer) {
+        thaw(); // 返回可写的引用，不能指向共享的内容
+        return const_cast<ValueData &>(static_cast<const TableData &>(*this).index_at(index));
+    }
+
+    const ValueData &TableData::index_at(const ValueData &index) const {
+        std::string_view bytes;
+        if (index.type != ValueType::Integer && !AsBytes(index, bytes)) {
             throw std::runtime_error("[squaker.table] Index must be a string or integer");
         }
-        if (array_map.find(index) == array_map.end()) {
+        const ValueData *value = find_index(index);
+        if (!value) {
             throw std::runtime_error("[squaker.table] Index out of range");
         }
-        return array_map[index];
+        return *value;
+    }
+
+    // 形状编号计数器
+    static std::atomic<uint32_t> nextShapeId{1};
+
+    TableShape::TableShape() : shapeId(nextShapeId.fetch_add(1, std::memory_order_relaxed)) {}
+
+    TableShape::TableShape(const TableShape &parent, Symbol name)
+        : shapeId(nextShapeId.fetch_add(1, std::memory_order_relaxed)), names(parent.names), sorted(parent.sorted) {
+        names.push_back(name);
+        auto pos = std::lower_bound(sorted.begin(), sorted.end(), name.str(),
+                                    [this](size_t slot, const std::string &key) { return names[slot].str() < key; });
+        sorted.insert(pos, names.size() - 1);
+    }
+
+    // 根形状：有意不释放，进程退出时仍被引用的表不会指向已析构的形状
+    const TableShape *TableShape::empty() {
+        static const TableShape *root = new TableShape();
+        return root;
+    }
+
+    size_t TableShape::find(const std::string &name) const {
+        // 成员少时直接按槽位比较，多时在有序槽位上二分
+        if (names.size() <= 8) {
+            for (size_t slot = 0; slot < names.size(); ++slot) {
+                if (names[slot].str() == name)
+                    return slot;
+            }
+            return npos;
+        }
+        auto pos = std::lower_bound(sorted.begin(), sorted.end(), name,
+                                    [this](size_t slot, const std::string &key) { return names[slot].str() < key; });
+        return pos != sorted.end() && names[*pos].str() == name ? *pos : npos;
+    }
+
+    size_t TableShape::find(Symbol name) const {
+        // 驻留的名字逐个比较地址，成员很多时才按文本二分
+        if (names.size() <= 32) {
+            for (size_t slot = 0; slot < names.size(); ++slot) {
+                if (names[slot] == name)
+                    return slot;
+            }
+            return npos;
+        }
+        return find(name.str());
+    }
+
+    const TableShape *TableShape::add(const std::string &name) const {
+        if (find(name) != npos) {
+            return this;
+        }
+        return add(Symbol(name));
+    }
+
+    const TableShape *TableShape::add(Symbol name) const {
+        if (find(name) != npos) {
+            return this;
+        }
+        std::lock_guard<std::mutex> lock(mutex);
+        auto &next = transitions[name];
+        if (!next) {
+            next.reset(new TableShape(*this, name));
+        }
+        return next.get();
+    }
+
+    const TableShape *TableShape::remove(size_t slot) const {
+        // 从根形状按原顺序重新加入其余成员，删除后得到的形状同样可以被共享
+        const TableShape *shape = empty();
+        for (size_t i = 0; i < names.size(); ++i) {
+            if (i != slot)
+                shape = shape->add(names[i]);
+        }
+        return shape;
+    }
+
+    // 记录类型的形状不挂在转移树上，按类型名与字段列表登记后复用，反复解析同一声明时不会重复创建
+    const TableShape *TableShape::record(std::string name, const std::vector<std::string> &fields) {
+        static std::mutex recordsMutex;
+        // 有意不释放（同根形状），进程退出时仍被引用的记录不会指向已析构的形状
+        static auto *records = new std::unordered_map<std::string, const TableShape *>();
+        std::string key = name;
+        for (const auto &field : fields) {
+            key += '\0';
+            key += field;
+        }
+        std::lock_guard<std::mutex> lock(recordsMutex);
+        const TableShape *&entry = (*records)[key];
+        if (entry) {
+            return entry;
+        }
+        auto *shape = new TableShape();
+        shape->sorted.resize(fields.size());
+        for (size_t slot = 0; slot < fields.size(); ++slot) {
+            shape->names.emplace_back(fields[slot]);
+            shape->sorted[slot] = slot;
+        }
+        std::sort(shape->sorted.begin(), shape->sorted.end(),
+                  [shape](size_t a, size_t b) { return shape->names[a].str() < shape->names[b].str(); });
+        shape->recordName = std::move(name);
+        entry = shape;
+        return shape;
+    }
+
+    // 记录类型的字段固定，不能增删
+    static void CheckUnsealed(const TableShape &shape, const std::string &name) {
+        if (shape.sealed()) {
+            throw std::runtime_error("[squaker.record] " + shape.record_name() + " has no field: " + name);
+        }
     }
 
     // 实现TableData的dot成员函数
     ValueData &TableData::dot(const std::string &name) {
-        return dot_map[name];
+        thaw();
+        size_t slot = shape->find(name);
+        if (slot == TableShape::npos) {
+            CheckUnsealed(*shape, name);
+            shape = shape->add(name);
+            slot = slots.size();
+            slots.emplace_back();
+        }
+        return slots[slot];
+    }
+
+    ValueData &TableData::dot(Symbol name) {
+        thaw();
+        size_t slot = shape->find(name);
+        if (slot == TableShape::npos) {
+            CheckUnsealed(*shape, name.str());
+            shape = shape->add(name);
+            slot = slots.size();
+            slots.emplace_back();
+        }
+        return slots[slot];
+    }
+
+    // 查找成员
+    ValueData *TableData::find_member(const std::string &name) {
+        thaw();
+        return const_cast<ValueData *>(static_cast<const TableData &>(*this).find_member(name));
+    }
+
+    const ValueData *TableData::find_member(const std::string &name) const {
+        size_t slot = shape->find(name);
+        return slot == TableShape::npos ? nullptr : &members()[slot];
+    }
+
+    // 成员不存在时加入
+    bool TableData::emplace_dot(const std::string &name, ValueData value) {
+        if (shape->find(name) != TableShape::npos) {
+            return false;
+        }
+        CheckUnsealed(*shape, name);
+        thaw();
+        shape = shape->add(name);
+        slots.push_back(std::move(value));
+        return true;
+    }
+
+    // 删除成员
+    bool TableData::erase_dot(const std::string &name) {
+        size_t slot = shape->find(name);
+        if (slot == TableShape::npos) {
+            return false;
+        }
+        if (shape->sealed()) {
+            throw std::runtime_error("[squaker.record] Cannot remove field " + name + " from " + shape->record_name());
+        }
+        thaw();
+        shape = shape->remove(slot);
+        slots.erase(slots.begin() + static_cast<std::ptrdiff_t>(slot));
+        return true;
     }
 
     // 实现TableData的dot_at成员函数
     ValueData &TableData::dot_at(const std::string &name) {
-        auto it = dot_map.find(name);
-        if (it == dot_map.end()) {
+        thaw();
+        return const_cast<ValueData &>(static_cast<const TableData &>(*this).dot_at(name));
+    }
+
+    const ValueData &TableData::dot_at(const std::string &name) const {
+        const ValueData *member = find_member(name);
+        if (!member) {
             throw std::runtime_error("[squaker.table] Key not found in dot map: " + name);
         }
-        return it->second;
+        return *member;
     }
 
     // 实现TableData的length成员函数
     size_t TableData::length() const {
-        return array_map.size() + dot_map.size();
+        return array_size() + dot_size();
     }
 
     // 实现ValueData的string成员函数
@@ -59,7 +513,7 @@ namespace squ {
         case ValueType::Char:
             return "'" + std::string(1, std::get<char>(value)) + "'";
         case ValueType::String:
-            return "\"" + std::get<std::string>(value) + "\"";
+            return "\"" + std::string(std::get<StringData>(value).view()) + "\"";
         case ValueType::Array: {
             std::string result = "[";
             const auto &arr = std::get<std::vector<ValueData>>(value);
@@ -73,30 +527,47 @@ namespace squ {
         case ValueType::Table: {
             std::string result = "[";
             const auto &table = std::get<TableData>(value);
-            for (const auto &pair : table.array_map) {
+            table.for_each_index([&result](const ValueData &key, const ValueData &value) {
                 if (result.size() > 1)
                     result += ", ";
-                result += pair.first.string() + "=" + pair.second.string();
-            }
-            for (const auto &pair : table.dot_map) {
+                result += key.string() + "=" + value.string();
+            });
+            table.for_each_dot([&result](const std::string &name, const ValueData &member) {
                 if (result.size() > 1)
                     result += ", ";
-                result += pair.first + ": " + pair.second.string();
-            }
+                result += name + ": " + member.string();
+            });
             return result + "]";
         }
         case ValueType::Function: {
             return "[function]";
         }
+        case ValueType::Object:
+            return std::get<std::shared_ptr<ObjectData>>(value)->string();
         default:
             return "[complex_value]";
         }
     }
 
-    // 比较两个ValueData对象
+    // 对象成员访问的默认实现
+    ValueData ObjectData::member(const std::string &name) {
+        throw std::runtime_error("[squaker.member] " + type_name() + " has no member: " + name);
+    }
+
+    // 比较两个ValueData对象（表键的顺序）
     bool operator<(const squ::ValueData &a, const squ::ValueData &b) noexcept {
-        if (a.type != b.type)
-            return a.type < b.type;
+        // 共享同一内容的字符串键（如来自同一个驻留的字面量）只比较地址
+        if (a.type == ValueType::String && b.type == ValueType::String)
+            return std::get<StringData>(a.value) < std::get<StringData>(b.value);
+        // 字符串与字节视图按内容比较，作为同一种键
+        std::string_view x, y;
+        bool xs = AsBytes(a, x), ys = AsBytes(b, y);
+        if (xs && ys)
+            return x < y;
+        ValueType ta = xs ? ValueType::String : a.type;
+        ValueType tb = ys ? ValueType::String : b.type;
+        if (ta != tb)
+            return ta < tb;
 
         using Func = std::function<squ::ValueData(std::vector<squ::ValueData>&, squ::VM &)>;
         return std::visit(
@@ -129,7 +600,7 @@ namespace squ {
             case ValueType::Char:
                 return std::get<char>(a.value) == std::get<char>(b.value);
             case ValueType::String:
-                return std::get<std::string>(a.value) == std::get<std::string>(b.value);
+                return std::get<StringData>(a.value) == std::get<StringData>(b.value);
             case ValueType::Array: {
                 const auto &arrA = std::get<std::vector<ValueData>>(a.value);
                 const auto &arrB = std::get<std::vector<ValueData>>(b.value);
@@ -143,11 +614,40 @@ namespace squ {
                 return &std::get<TableData>(a.value) == &std::get<TableData>(b.value);
             case ValueType::Function:
                 return &a == &b; // 函数比较地址
+            case ValueType::Object:
+                return std::get<std::shared_ptr<ObjectData>>(a.value) == std::get<std::shared_ptr<ObjectData>>(b.value);
             default:
                 return false; // 未知类型
         }
     }
 
+    // 类型名
+    const char *TypeName(ValueType type) {
+        switch (type) {
+            case ValueType::Nil:
+                return "nil";
+            case ValueType::Integer:
+                return "integer";
+            case ValueType::Real:
+                return "real";
+            case ValueType::Bool:
+                return "bool";
+            case ValueType::Char:
+                return "char";
+            case ValueType::String:
+                return "string";
+            case ValueType::Function:
+                return "function";
+            case ValueType::Array:
+                return "array";
+            case ValueType::Table:
+                return "table";
+            case ValueType::Object:
+                return "object";
+        }
+        return "unknown";
+    }
+
 } // namespace squ
 
 template <> struct std::less<std::function<squ::ValueData(std::vector<squ::ValueData>, squ::VM &)>> {
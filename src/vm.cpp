@@ -4,6 +4,22 @@
 
 namespace squ {
 
+    // 调整分段栈大小
+    void SegmentedStack::resize(size_t n) {
+        if (n > count) {
+            // 按需追加新段，已分配的段保持原地不动
+            while (segments.size() * kSegmentSize < n) {
+                segments.emplace_back(new ValueData[kSegmentSize]);
+            }
+        } else {
+            // 释放的槽位重置为Nil，避免残留值在下次进入帧时被读到
+            for (size_t i = n; i < count; ++i) {
+                (*this)[i] = ValueData{};
+            }
+        }
+        count = n;
+    }
+
     // 进入函数
     void VM::enter(size_t localsNeeded) {
         size_t base = mem.size();
@@ -11,7 +27,7 @@ namespace squ {
             throw std::runtime_error("[squaker.vm.enter] stack overflow");
         }
         mem.resize(base + localsNeeded);
-        callStack.emplace_back(base, 0);
+        callStack.emplace_back(base, 0, localsNeeded);
     }
 
     // 离开函数
@@ -29,17 +45,18 @@ namespace squ {
     ValueData &VM::local(size_t slot) {
         if (callStack.empty())
             throw std::runtime_error("[squaker.vm.local] access local without frame");
-        if (slot >= mem.size())
+        const Frame &frame = callStack.back();
+        if (slot >= frame.size)
             throw std::runtime_error("[squaker.vm.local] local slot out of range: " + std::to_string(slot));
         // 返回局部变量的引用
-        return mem[callStack.back().base + slot];
+        return mem[frame.base + slot];
     }
 
     // 打印当前调用栈
     void VM::printStack() const {
         printf("[squaker.vm.stack] Current call stack:\n");
         for (const auto &frame : callStack) {
-            printf("  Frame(base=%zu, retAddr=%zu)\n", frame.base, frame.retAddr);
+            printf("  Frame(base=%zu, retAddr=%zu, size=%zu)\n", frame.base, frame.retAddr, frame.size);
         }
         printf("[squaker.vm.stack] Total frames: %zu\n", callStack.size());
         printf("[squaker.vm.stack] Memory size: %zu\n", mem.size());
@@ -14,7 +14,7 @@ int main(int argc, char **argv) {
     std::string script_path = argv[1];
     try {
         squ::Script script;
-        script.execute(squ::ReadFile(script_path));
+        script.execute_file(script_path);
         std::cout << "Script executed successfully." << std::endl;
     } catch (const std::exception &e) {
         std::cerr << "[Error] " << e.what() << std::endl;